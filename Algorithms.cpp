@@ -1,77 +1,334 @@
 #include <iostream>
 #include "Algorithms.hpp"
+#include "DepthFirstSearch.hpp"
+#include "IndexedHeap.hpp"
+#include <algorithm>
 #include <queue>
 #include <stack>
 #include <unordered_set>
 #include <unordered_map>
 #include <limits>
+#include <chrono>
 
 namespace ariel {
+    const unsigned int DepthFirstSearch::NO_PARENT;
+
+    static std::function<void(const AlgorithmStats &)> statsHook;
+
+    void Algorithms::setStatsHook(std::function<void(const AlgorithmStats &)> hook) {
+        statsHook = hook;
+    }
+
+    static void reportStats(AlgorithmStats &stats, std::chrono::steady_clock::time_point startTime) {
+        if (statsHook) {
+            stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            statsHook(stats);
+        }
+    }
+
     int Algorithms::isConnected(const Graph &g) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        AlgorithmStats stats = {"isConnected", 0, 0, 0, 0.0};
         unsigned int num = g.getNumVertices();
-        bool *vis = new bool[num];
-        for (unsigned int u = 0; u < num; u++){
-            for (unsigned int i = 0; i < num; i++){
-                vis[i] = false;
-            }
-            
-            traverseGraph(g, u, vis);
-            
-            for (unsigned int i = 0; i < num; i++){
-                if (!vis[i]) {
-                    return 0;
+        int connected = 1;
+        if (num > 0) {
+            stats.traversals++;
+            if (traverseGraph(g, 0, stats) != num) {
+                connected = 0;
+            } else if (!g.isSymmetric()) {
+                // Strongly connected iff every vertex can also reach vertex 0
+                Graph reversed = g.transpose();
+                stats.traversals++;
+                if (traverseGraph(reversed, 0, stats) != num) {
+                    connected = 0;
                 }
             }
         }
-        return 1;
+        reportStats(stats, startTime);
+        return connected;
     }
 
+    static const unsigned int NO_VERTEX = static_cast<unsigned int>(-1);
+
     std::string Algorithms::shortestPath(const Graph &g, unsigned int start, unsigned int end){
-        unsigned int n = g.getNumVertices();
+        return shortestPath(g, start, end, PathOptions());
+    }
+
+    std::string Algorithms::shortestPath(const Graph &g, unsigned int start, unsigned int end, const PathOptions &options){
+        PathResult result;
+        findPath(g, start, end, result, options);
+        return formatPath(result);
+    }
+
+    bool Algorithms::findPath(const Graph &g, unsigned int start, unsigned int end, PathResult &result, const PathOptions &options){
+        result.found = false;
+        result.vertices.clear();
+        result.distance = 0;
+        if (start == end) {
+            result.found = true;
+            result.vertices.push_back(start);
+            return true;
+        }
+        PathMethod method = options.method;
+        if (method == PathMethod::Auto) {
+            // The cached weight range picks the cheapest method that still respects the weights
+            if (g.hasNegativeWeight()) {
+                method = PathMethod::BellmanFord;
+            } else if (g.getMinWeight() == g.getMaxWeight()) {
+                method = PathMethod::BreadthFirst;
+            } else {
+                method = PathMethod::Dijkstra;
+            }
+        }
+
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        AlgorithmStats stats = {"shortestPath", 1, 0, 0, 0.0};
+        std::vector<unsigned int> parent(g.getNumVertices(), NO_VERTEX);
+        bool found = false;
+        switch (method) {
+            case PathMethod::Dijkstra:
+                found = dijkstraPath(g, start, end, parent, stats);
+                break;
+            case PathMethod::BellmanFord:
+                found = bellmanFordPath(g, start, end, parent, stats);
+                break;
+            case PathMethod::Bidirectional:
+                if (options.reversed != nullptr) {
+                    found = bidirectionalPath(g, *options.reversed, start, end, parent, stats);
+                } else if (g.isSymmetric()) {
+                    found = bidirectionalPath(g, g, start, end, parent, stats);
+                } else {
+                    found = bidirectionalPath(g, g.transpose(), start, end, parent, stats);
+                }
+                break;
+            default:
+                found = breadthFirstPath(g, start, end, parent, stats);
+                break;
+        }
+        reportStats(stats, startTime);
+        if (!found) {
+            return false;
+        }
+
+        // Walk the parents back from end, then flip: O(path length)
+        for (unsigned int node = end; node != start; node = parent[node]) {
+            result.vertices.push_back(node);
+        }
+        result.vertices.push_back(start);
+        std::reverse(result.vertices.begin(), result.vertices.end());
+        for (std::size_t i = 0; i + 1 < result.vertices.size(); i++) {
+            result.distance += g.getWeight(result.vertices[i], result.vertices[i + 1]);
+        }
+        result.found = true;
+        return true;
+    }
+
+    std::string Algorithms::formatPath(const PathResult &result){
+        if (!result.found) {
+            return "-1";
+        }
+        std::string path;
+        for (std::size_t i = 0; i < result.vertices.size(); i++) {
+            if (i > 0) {
+                path += "->";
+            }
+            path += std::to_string(result.vertices[i]);
+        }
+        return path;
+    }
+
+    bool Algorithms::breadthFirstPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats){
+        if (g.getRepresentation() == Representation::Bitset) {
+            return bitsetBreadthFirstPath(g, start, end, parent, stats);
+        }
         std::queue<unsigned int> q;
-        std::vector<bool> visited(n, false);
-        std::vector<int> parent(n, -1);
+        std::vector<bool> visited(g.getNumVertices(), false);
         q.push(start);
         visited[start] = true;
+        stats.verticesVisited++;
 
         while (!q.empty()) {
             unsigned int current = q.front();
             q.pop();
 
-            for (unsigned int neighbor = 0; neighbor < n; neighbor++) {
-                if (!visited[neighbor] && g.containsEdge(current, neighbor)) {
+            for (Neighbor next : g.neighbors(current)) {
+                unsigned int neighbor = next.vertex;
+                stats.edgesScanned++;
+                if (!visited[neighbor]) {
                     q.push(neighbor);
                     visited[neighbor] = true;
-                    parent[neighbor] = (int) current;
-
+                    parent[neighbor] = current;
+                    stats.verticesVisited++;
                     if (neighbor == end) {
-                        std::string path;
-                        unsigned int node = end;
-                        while (node != start) {
-                            if (node != end) {
-                                path = std::to_string(node) + "->" + path;
-                            } else {
-                                path = std::to_string(node) + path;
-                            }
-                            node = (unsigned int) parent[node];
-                        }
-                        return std::to_string(start) + "->" + path;
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
+    // Level-synchronous BFS from both ends. Each round expands the whole smaller frontier; once a
+    // round meets the other side, the best meeting edge of that round lies on a shortest path.
+    bool Algorithms::bidirectionalPath(const Graph &g, const Graph &reversed, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats){
+        unsigned int n = g.getNumVertices();
+        std::vector<unsigned int> distForward(n, NO_VERTEX);
+        std::vector<unsigned int> distBackward(n, NO_VERTEX);
+        std::vector<unsigned int> parentBackward(n, NO_VERTEX);
+        std::vector<unsigned int> forward(1, start);
+        std::vector<unsigned int> backward(1, end);
+        std::vector<unsigned int> next;
+        distForward[start] = 0;
+        distBackward[end] = 0;
+        stats.verticesVisited += 2;
+        stats.traversals = 2;
+
+        unsigned int bestLength = NO_VERTEX;
+        unsigned int meetFrom = NO_VERTEX; // the shortest path uses the edge meetFrom -> meetTo
+        unsigned int meetTo = NO_VERTEX;
+        while (!forward.empty() && !backward.empty() && bestLength == NO_VERTEX) {
+            bool expandForward = forward.size() <= backward.size();
+            const Graph &side = expandForward ? g : reversed;
+            std::vector<unsigned int> &frontier = expandForward ? forward : backward;
+            std::vector<unsigned int> &dist = expandForward ? distForward : distBackward;
+            std::vector<unsigned int> &otherDist = expandForward ? distBackward : distForward;
+            std::vector<unsigned int> &sideParent = expandForward ? parent : parentBackward;
+
+            next.clear();
+            for (unsigned int u : frontier) {
+                for (Neighbor edge : side.neighbors(u)) {
+                    unsigned int v = edge.vertex;
+                    stats.edgesScanned++;
+                    if (otherDist[v] != NO_VERTEX && dist[u] + 1 + otherDist[v] < bestLength) {
+                        bestLength = dist[u] + 1 + otherDist[v];
+                        meetFrom = expandForward ? u : v;
+                        meetTo = expandForward ? v : u;
+                    }
+                    if (dist[v] == NO_VERTEX) {
+                        dist[v] = dist[u] + 1;
+                        sideParent[v] = u;
+                        next.push_back(v);
+                        stats.verticesVisited++;
+                    }
+                }
+            }
+            frontier.swap(next);
+        }
+        if (bestLength == NO_VERTEX) {
+            return false;
+        }
+
+        // Splice the backward half into parent so it reads end -> ... -> meetTo -> meetFrom -> ... -> start
+        parent[meetTo] = meetFrom;
+        for (unsigned int x = meetTo; x != end; x = parentBackward[x]) {
+            parent[parentBackward[x]] = x;
+        }
+        return true;
+    }
+
+    // Dijkstra with a 4-ary indexed heap: O(E log V), stops as soon as end is settled
+    bool Algorithms::dijkstraPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats){
+        unsigned int n = g.getNumVertices();
+        std::vector<long long> dist(n, std::numeric_limits<long long>::max());
+        std::vector<bool> settled(n, false);
+        IndexedHeap<long long> heap(n);
+        dist[start] = 0;
+        heap.pushOrDecrease(start, 0);
+
+        while (!heap.empty()) {
+            unsigned int u = heap.pop();
+            stats.verticesVisited++;
+            if (u == end) {
+                return true;
+            }
+            settled[u] = true;
+            for (Neighbor next : g.neighbors(u)) {
+                stats.edgesScanned++;
+                long long candidate = dist[u] + next.weight;
+                if (!settled[next.vertex] && candidate < dist[next.vertex]) {
+                    dist[next.vertex] = candidate;
+                    parent[next.vertex] = u;
+                    heap.pushOrDecrease(next.vertex, candidate);
+                }
+            }
+        }
+        return false;
+    }
+
+    // Queue based Bellman-Ford (SPFA): only vertices whose distance changed are relaxed again.
+    // A path of n or more edges means a negative cycle is reachable from start.
+    bool Algorithms::bellmanFordPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats){
+        unsigned int n = g.getNumVertices();
+        std::vector<long long> dist(n, std::numeric_limits<long long>::max());
+        std::vector<unsigned int> edgesOnPath(n, 0);
+        std::vector<bool> queued(n, false);
+        std::queue<unsigned int> q;
+        dist[start] = 0;
+        q.push(start);
+        queued[start] = true;
+
+        while (!q.empty()) {
+            unsigned int u = q.front();
+            q.pop();
+            queued[u] = false;
+            stats.verticesVisited++;
+            for (Neighbor next : g.neighbors(u)) {
+                unsigned int v = next.vertex;
+                stats.edgesScanned++;
+                long long candidate = dist[u] + next.weight;
+                if (candidate < dist[v]) {
+                    dist[v] = candidate;
+                    parent[v] = u;
+                    edgesOnPath[v] = edgesOnPath[u] + 1;
+                    if (edgesOnPath[v] >= n) {
+                        return false;
+                    }
+                    if (!queued[v]) {
+                        q.push(v);
+                        queued[v] = true;
                     }
                 }
             }
         }
-        return "-1";
+        return dist[end] != std::numeric_limits<long long>::max();
     }
 
+    // Reports the first edge to a visited vertex other than the parent, like the recursive version did
+    struct CycleFinder : DfsVisitor {
+        explicit CycleFinder(const DepthFirstSearch &dfs) : dfs(dfs) {}
+
+        bool nonTreeEdge(unsigned int v, Neighbor next) {
+            unsigned int u = next.vertex;
+            if (u == dfs.getParent(v)) {
+                return true;
+            }
+            std::cout << "Cycle found: ";
+            std::stack<unsigned int> cycleStack;
+            cycleStack.push(u);
+            for (unsigned int x = v; x != u && x != DepthFirstSearch::NO_PARENT; x = dfs.getParent(x)) {
+                cycleStack.push(x);
+            }
+            cycleStack.push(u);
+
+            while (!cycleStack.empty()) {
+                std::cout << cycleStack.top() << " ";
+                cycleStack.pop();
+            }
+            std::cout << std::endl;
+            return false;
+        }
+
+        const DepthFirstSearch &dfs;
+    };
+
     int Algorithms::isContainsCycle(const Graph &g) {
         unsigned int num = g.getNumVertices();
-        std::vector<bool> visited(num, false);
-        std::vector<int> parent(num, -1);
+        DepthFirstSearch dfs(g);
+        CycleFinder finder(dfs);
 
         for (unsigned int i = 0; i < num; ++i) {
-            if (!visited[i]) {
-                parent[i] = -1;
-                if (isContainsCycleRecursive(g, i, visited, parent)){
+            if (!dfs.isVisited(i)) {
+                if (!dfs.run(i, finder)) {
                     return 1;
                 }
             }
@@ -82,23 +339,28 @@ namespace ariel {
     std::string Algorithms::isBipartite(const Graph &g) {
         unsigned int src = 0;
         unsigned int num = g.getNumVertices();
-        int colorArr[num];
-        for (int i = 0; i < num; ++i)
-            colorArr[i] = -1;
+        std::vector<int> colorArr(num, -1);
         colorArr[src] = 1;
         std::queue<unsigned int> q;
         q.push(src);
 
-        while (!q.empty()) {
-            unsigned int u = q.front();
-            q.pop();
+        if (g.getRepresentation() == Representation::Bitset) {
+            if (!bitsetTwoColoring(g, colorArr)) {
+                return "0";
+            }
+        } else {
+            while (!q.empty()) {
+                unsigned int u = q.front();
+                q.pop();
 
-            for (unsigned int v = 0; v < num; ++v) {
-                if (g.containsEdge(u, v) && colorArr[v] == -1) {
-                    colorArr[v] = 1 - colorArr[u];
-                    q.push(v);
-                } else if (g.containsEdge(u, v) && colorArr[v] == colorArr[u]) {
-                    return "0";
+                for (Neighbor next : g.neighbors(u)) {
+                    unsigned int v = next.vertex;
+                    if (colorArr[v] == -1) {
+                        colorArr[v] = 1 - colorArr[u];
+                        q.push(v);
+                    } else if (colorArr[v] == colorArr[u]) {
+                        return "0";
+                    }
                 }
             }
         }
@@ -120,77 +382,237 @@ namespace ariel {
         return "The graph is bipartite: A={" + partitionA + "}, B={" + partitionB + "}";
     }
     
-    // Using bellman ford algorithm for detecting negative cycle
     bool Algorithms::negativeCycle(const Graph &g) {
+        std::vector<unsigned int> cycle;
+        return negativeCycle(g, cycle);
+    }
+
+    // Queue based Bellman-Ford from a virtual source joined to every vertex by a 0-weight edge,
+    // so cycles are found wherever they are. It stops as soon as the queue drains, and a
+    // shortest path of n or more edges means the parent pointers have closed a negative cycle.
+    bool Algorithms::negativeCycle(const Graph &g, std::vector<unsigned int> &cycle) {
         unsigned int num = g.getNumVertices();
-        std::vector<int> dist(num, std::numeric_limits<int>::max());
-        dist[0] = 0;
-
-        for (unsigned int i = 0; i < num - 1; i++) {
-            for (unsigned int u = 0; u < num; u++) {
-                for (unsigned int v = 0; v < num; v++) {
-                    if (g.containsEdge(u, v) && dist[u] != std::numeric_limits<int>::max()) {
-                        if(dist[u] + g.getWeight(u, v) < dist[v]) {
-                            dist[v] = dist[u] + g.getWeight(u, v);
-                        }
-                    }
-                }
-            }
+        cycle.clear();
+        if (!g.hasNegativeWeight()) {
+            return false;
+        }
+        std::vector<long long> dist(num, 0);
+        std::vector<unsigned int> parent(num, NO_VERTEX);
+        std::vector<unsigned int> edgesOnPath(num, 0);
+        std::vector<bool> queued(num, true);
+        std::queue<unsigned int> q;
+        for (unsigned int u = 0; u < num; u++) {
+            q.push(u);
         }
 
-        for (unsigned int u = 0; u < num; ++u) {
-            for (unsigned int v = 0; v < num; ++v) {
-                if (g.containsEdge(u, v) && dist[u] != std::numeric_limits<int>::max() && dist[u] + g.getWeight(u, v) < dist[v]) {
-                    std::cout << "Negative cycle found!" << std::endl;
+        while (!q.empty()) {
+            unsigned int u = q.front();
+            q.pop();
+            queued[u] = false;
+            for (Neighbor next : g.neighbors(u)) {
+                unsigned int v = next.vertex;
+                if (dist[u] + next.weight >= dist[v]) {
+                    continue;
+                }
+                dist[v] = dist[u] + next.weight;
+                parent[v] = u;
+                edgesOnPath[v] = edgesOnPath[u] + 1;
+                if (edgesOnPath[v] >= num && findParentCycle(parent, v, cycle)) {
                     return true;
                 }
+                if (!queued[v]) {
+                    q.push(v);
+                    queued[v] = true;
+                }
             }
         }
-
-        std::cout << "No negative cycle found." << std::endl;
         return false;
     }
 
-    void Algorithms::traverseGraph(const Graph &g, unsigned int u, bool visited[]) {
-        visited[u] = true;
-        unsigned int num = g.getNumVertices();
-        for (unsigned int v = 0; v < num; v++) {
-            if (g.containsEdge(u, v)) {
-                if (!visited[v]) {
-                    traverseGraph(g, v, visited);
-                }
+    bool Algorithms::findParentCycle(const std::vector<unsigned int> &parent, unsigned int from, std::vector<unsigned int> &cycle) {
+        // Every vertex has at most one parent, so each walk either stops at a root or runs into
+        // a cycle; stamping vertices with the walk that reached them makes the scan O(n) overall
+        unsigned int num = static_cast<unsigned int>(parent.size());
+        std::vector<unsigned int> walk(num, NO_VERTEX);
+        for (unsigned int i = 0; i <= num; i++) {
+            unsigned int begin = i == 0 ? from : i - 1;
+            unsigned int x = begin;
+            while (x != NO_VERTEX && walk[x] == NO_VERTEX) {
+                walk[x] = begin;
+                x = parent[x];
             }
+            if (x == NO_VERTEX || walk[x] != begin) {
+                continue;
+            }
+
+            // x is on the cycle; parents point backwards along the edges
+            unsigned int y = x;
+            do {
+                cycle.push_back(y);
+                y = parent[y];
+            } while (y != x);
+            std::reverse(cycle.begin(), cycle.end());
+            std::rotate(cycle.begin(), std::min_element(cycle.begin(), cycle.end()), cycle.end());
+            return true;
         }
+        return false;
     }
 
-    bool Algorithms::isContainsCycleRecursive(const Graph &g, unsigned int v, std::vector<bool> &visited, std::vector<int> &parent) {
-        visited[v] = true;
-        unsigned int size;
-        unsigned int *neighbors = g.getNeighbors(v, size);
+    // Counts the vertices and edges seen by a traversal
+    struct ReachCounter : DfsVisitor {
+        ReachCounter() : vertices(0), edges(0) {}
 
-        for (unsigned int i = 0; i < size; i++) {
-            unsigned int u = neighbors[i];
-            if (!visited[u]) {
-                parent[u] = (int)v;
-                if (isContainsCycleRecursive(g, u, visited, parent))
-                    return true;
-            } else if (u != parent[v]) {
-                std::cout << "Cycle found: ";
-                std::stack<unsigned int> cycleStack;
-                cycleStack.push(u);
-                for (unsigned int x = v; x != u; x = (unsigned int) parent[x]){
-                    cycleStack.push(x);
+        bool preVisit(unsigned int /*u*/) {
+            vertices++;
+            return true;
+        }
+
+        bool treeEdge(unsigned int /*u*/, Neighbor /*next*/) {
+            edges++;
+            return true;
+        }
+
+        bool nonTreeEdge(unsigned int /*u*/, Neighbor /*next*/) {
+            edges++;
+            return true;
+        }
+
+        unsigned int vertices;
+        std::size_t edges;
+    };
+
+    unsigned int Algorithms::traverseGraph(const Graph &g, unsigned int u, AlgorithmStats &stats) {
+        if (g.getRepresentation() == Representation::Bitset) {
+            return bitsetReach(g, u, stats);
+        }
+        DepthFirstSearch dfs(g);
+        ReachCounter counter;
+        dfs.run(u, counter);
+        stats.verticesVisited += counter.vertices;
+        stats.edgesScanned += counter.edges;
+        return counter.vertices;
+    }
+
+    // Bitset graphs: frontiers and visited sets are bitsets too, so each frontier vertex claims all its
+    // unvisited neighbors with one AND NOT per 64 vertices instead of one test per entry.
+
+    static bool isSet(const std::vector<std::uint64_t> &bits, unsigned int v) {
+        return (bits[v / 64] >> (v % 64) & 1) != 0;
+    }
+
+    static void setBit(std::vector<std::uint64_t> &bits, unsigned int v) {
+        bits[v / 64] |= std::uint64_t(1) << (v % 64);
+    }
+
+    static bool isEmpty(const std::vector<std::uint64_t> &bits) {
+        for (std::uint64_t word : bits) {
+            if (word != 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Expand one level: every vertex of frontier claims its unvisited out-neighbors, which are marked
+    // visited and collected in next. claim(u, w, fresh) sees each newly claimed word and returns false to stop.
+    template <typename Claim>
+    static bool expandFrontier(const Graph &g, const std::vector<std::uint64_t> &frontier, std::vector<std::uint64_t> &visited,
+                               std::vector<std::uint64_t> &next, AlgorithmStats &stats, Claim claim) {
+        std::size_t words = frontier.size();
+        std::fill(next.begin(), next.end(), 0);
+        for (std::size_t fw = 0; fw < words; fw++) {
+            for (std::uint64_t pending = frontier[fw]; pending != 0; pending &= pending - 1) {
+                unsigned int u = static_cast<unsigned int>(fw * 64 + static_cast<std::size_t>(__builtin_ctzll(pending)));
+                const std::uint64_t *row = g.getBitRow(u);
+                stats.edgesScanned += words;
+                for (std::size_t w = 0; w < words; w++) {
+                    std::uint64_t fresh = row[w] & ~visited[w];
+                    if (fresh != 0) {
+                        visited[w] |= fresh;
+                        next[w] |= fresh;
+                        if (!claim(u, w, fresh)) {
+                            return false;
+                        }
+                    }
                 }
-                cycleStack.push(u);
+            }
+        }
+        return true;
+    }
 
-                while (!cycleStack.empty()) {
-                    std::cout << cycleStack.top() << " ";
-                    cycleStack.pop();
+    bool Algorithms::bitsetBreadthFirstPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats) {
+        std::size_t words = g.getBitRowStride();
+        std::vector<std::uint64_t> visited(words, 0), frontier(words, 0), next(words, 0);
+        setBit(visited, start);
+        setBit(frontier, start);
+        stats.verticesVisited++;
+        bool found = false;
+        while (!found && !isEmpty(frontier)) {
+            expandFrontier(g, frontier, visited, next, stats, [&](unsigned int u, std::size_t w, std::uint64_t fresh) {
+                for (; fresh != 0; fresh &= fresh - 1) {
+                    unsigned int v = static_cast<unsigned int>(w * 64 + static_cast<std::size_t>(__builtin_ctzll(fresh)));
+                    parent[v] = u;
+                    stats.verticesVisited++;
                 }
-                std::cout << std::endl;
+                found = isSet(visited, end);
+                return !found;
+            });
+            frontier.swap(next);
+        }
+        return found;
+    }
+
+    unsigned int Algorithms::bitsetReach(const Graph &g, unsigned int u, AlgorithmStats &stats) {
+        std::size_t words = g.getBitRowStride();
+        std::vector<std::uint64_t> visited(words, 0), frontier(words, 0), next(words, 0);
+        setBit(visited, u);
+        setBit(frontier, u);
+        unsigned int reached = 1;
+        while (!isEmpty(frontier)) {
+            expandFrontier(g, frontier, visited, next, stats, [&reached](unsigned int, std::size_t, std::uint64_t fresh) {
+                reached += static_cast<unsigned int>(__builtin_popcountll(fresh));
                 return true;
+            });
+            frontier.swap(next);
+        }
+        stats.verticesVisited += reached;
+        return reached;
+    }
+
+    // Same coloring as the queue-based BFS of isBipartite: levels from vertex 0 alternate between
+    // colors 1 and 0, and an edge into the current level's own color closes an odd cycle
+    bool Algorithms::bitsetTwoColoring(const Graph &g, std::vector<int> &colors) {
+        std::size_t words = g.getBitRowStride();
+        std::vector<std::uint64_t> visited(words, 0), frontier(words, 0), next(words, 0);
+        std::vector<std::uint64_t> colored[2] = {std::vector<std::uint64_t>(words, 0), std::vector<std::uint64_t>(words, 0)};
+        setBit(visited, 0);
+        setBit(frontier, 0);
+        setBit(colored[1], 0);
+        int color = 1;
+        while (!isEmpty(frontier)) {
+            std::vector<std::uint64_t> &same = colored[color];
+            std::vector<std::uint64_t> &other = colored[1 - color];
+            std::fill(next.begin(), next.end(), 0);
+            for (std::size_t fw = 0; fw < words; fw++) {
+                for (std::uint64_t pending = frontier[fw]; pending != 0; pending &= pending - 1) {
+                    const std::uint64_t *row = g.getBitRow(static_cast<unsigned int>(fw * 64 + static_cast<std::size_t>(__builtin_ctzll(pending))));
+                    for (std::size_t w = 0; w < words; w++) {
+                        if ((row[w] & same[w]) != 0) {
+                            return false;
+                        }
+                        std::uint64_t fresh = row[w] & ~visited[w];
+                        visited[w] |= fresh;
+                        next[w] |= fresh;
+                        other[w] |= fresh;
+                    }
+                }
             }
+            frontier.swap(next);
+            color = 1 - color;
         }
-        return false;
+        for (unsigned int v = 0; v < colors.size(); v++) {
+            colors[v] = isSet(colored[1], v) ? 1 : (isSet(colored[0], v) ? 0 : -1);
+        }
+        return true;
     }
-} // namespace ariel
\ No newline at end of file
+} // namespace ariel
@@ -2,18 +2,67 @@
 #define ALGORITHMS_HPP
 
 #include "Graph.hpp"
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <unordered_set>
 #include <unordered_map>
 
 namespace ariel {
+    // Work done by one algorithm call, reported through Algorithms::setStatsHook
+    struct AlgorithmStats {
+        const char *algorithm;
+        unsigned int traversals;
+        std::size_t verticesVisited;
+        std::size_t edgesScanned; // for bitset graphs: adjacency words scanned, 64 potential edges each
+        double elapsedSeconds;
+    };
+
+    // How shortestPath searches
+    enum class PathMethod {
+        Auto,         // breadth-first search if every edge has the same positive weight, Dijkstra if no weight is negative, Bellman-Ford otherwise
+        BreadthFirst, // fewest edges, ignoring weights
+        Bidirectional, // fewest edges, searching from both ends and always expanding the smaller frontier
+        Dijkstra,     // lightest path; requires non-negative weights
+        BellmanFord   // lightest path with any weights (queue based, stops early)
+    };
+
+    struct PathOptions {
+        PathOptions(PathMethod method = PathMethod::Auto, const Graph *reversed = nullptr) : method(method), reversed(reversed) {}
+
+        PathMethod method;
+
+        // Transpose of the graph for the backward half of Bidirectional on non-symmetric graphs.
+        // Computed on every call when null, so pass it in when running many queries.
+        const Graph *reversed;
+    };
+
+    // A path found by Algorithms::findPath
+    struct PathResult {
+        bool found;
+        std::vector<unsigned int> vertices; // start, ..., end (empty if not found)
+        long long distance;                 // sum of the edge weights along the path
+    };
+
     class Algorithms {
     public:
-        // Check if the graph is connected
+        // Receives the stats of every instrumented call (isConnected, shortestPath); pass nullptr to disable
+        static void setStatsHook(std::function<void(const AlgorithmStats &)> hook);
+
+        // Check if the graph is (strongly) connected
+        // One traversal for symmetric graphs, a forward and a reverse one otherwise: O(V+E)
         static int isConnected(const Graph& g);
 
-        // Find the shortest path between two vertices
+        // Find the shortest path between two vertices ("-1" if there is none, or if a negative cycle is reachable from start)
         static std::string shortestPath(const Graph& g, unsigned int start, unsigned int end);
+        static std::string shortestPath(const Graph& g, unsigned int start, unsigned int end, const PathOptions& options);
+
+        // Same search without building strings; result is overwritten and its vector capacity reused.
+        // Returns result.found.
+        static bool findPath(const Graph& g, unsigned int start, unsigned int end, PathResult& result, const PathOptions& options = PathOptions());
+
+        // "start->...->end", or "-1" if no path was found
+        static std::string formatPath(const PathResult& result);
 
         // Check if the graph contains a cycle
         static int isContainsCycle(const Graph& g);
@@ -21,13 +70,29 @@ namespace ariel {
         // Check if the graph is bipartite
         static std::string isBipartite(const Graph& g);
 
-        // Check if the graph has a negative cycle
+        // Check if the graph has a negative cycle anywhere (edges are directed u -> v)
         static bool negativeCycle(const Graph& g);
 
+        // Same, and fill cycle with its vertices c0, c1, ..., ck-1 (edges ci -> ci+1 and ck-1 -> c0)
+        static bool negativeCycle(const Graph& g, std::vector<unsigned int>& cycle);
+
     private:
-        // Helper function for checking cycle
-        static bool isContainsCycleRecursive(const Graph &g, unsigned int v, std::vector<bool> &visited, std::vector<int> &parent);
-        static void traverseGraph(const Graph &g, unsigned int u, bool visited[]);
+        // Path searches fill parent[] and return false if end is unreachable
+        static bool breadthFirstPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats);
+        static bool bidirectionalPath(const Graph &g, const Graph &reversed, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats);
+        static bool dijkstraPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats);
+        static bool bellmanFordPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats);
+
+        // Word-parallel versions for bitset graphs
+        static bool bitsetBreadthFirstPath(const Graph &g, unsigned int start, unsigned int end, std::vector<unsigned int> &parent, AlgorithmStats &stats);
+        static unsigned int bitsetReach(const Graph &g, unsigned int u, AlgorithmStats &stats);
+        static bool bitsetTwoColoring(const Graph &g, std::vector<int> &colors);
+
+        // Look for a cycle in the parent pointers, first from the given vertex, then everywhere
+        static bool findParentCycle(const std::vector<unsigned int> &parent, unsigned int from, std::vector<unsigned int> &cycle);
+
+        // Number of vertices reachable from u (u included)
+        static unsigned int traverseGraph(const Graph &g, unsigned int u, AlgorithmStats &stats);
     };
 
 } // namespace ariel
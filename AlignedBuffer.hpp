@@ -0,0 +1,124 @@
+#ifndef ALIGNED_BUFFER_HPP
+#define ALIGNED_BUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace ariel {
+    // Fixed-size, zero-initialized array whose first element starts on a cache line.
+    // Only meant for trivially copyable element types (int, unsigned, words).
+    // It can also be a view of memory that an owner keeps alive, such as a mapped file.
+    template <typename T>
+    class AlignedBuffer {
+        public:
+            static const std::size_t ALIGNMENT = 64;
+
+            AlignedBuffer() : ptr(nullptr), count(0) {}
+
+            explicit AlignedBuffer(std::size_t n) : ptr(allocate(n)), count(n) {}
+
+            // The n elements at data, released with owner instead of freed; copies allocate as usual
+            AlignedBuffer(T *data, std::size_t n, std::shared_ptr<void> owner) : ptr(data), count(n), owner(std::move(owner)) {}
+
+            AlignedBuffer(const AlignedBuffer &other) : ptr(allocate(other.count)), count(other.count)
+            {
+                if (count != 0)
+                {
+                    std::memcpy(ptr, other.ptr, count * sizeof(T));
+                }
+            }
+
+            AlignedBuffer(AlignedBuffer &&other) noexcept : ptr(other.ptr), count(other.count), owner(std::move(other.owner))
+            {
+                other.ptr = nullptr;
+                other.count = 0;
+            }
+
+            AlignedBuffer &operator=(const AlignedBuffer &other)
+            {
+                if (this != &other)
+                {
+                    AlignedBuffer copy(other);
+                    swap(copy);
+                }
+                return *this;
+            }
+
+            AlignedBuffer &operator=(AlignedBuffer &&other) noexcept
+            {
+                swap(other);
+                return *this;
+            }
+
+            ~AlignedBuffer()
+            {
+                if (!owner)
+                {
+                    deallocate(ptr);
+                }
+            }
+
+            // Replace the contents with n zeroed elements
+            void reset(std::size_t n)
+            {
+                AlignedBuffer fresh(n);
+                swap(fresh);
+            }
+
+            void swap(AlignedBuffer &other) noexcept
+            {
+                std::swap(ptr, other.ptr);
+                std::swap(count, other.count);
+                owner.swap(other.owner);
+            }
+
+            T *data() { return ptr; }
+            const T *data() const { return ptr; }
+            std::size_t size() const { return count; }
+            bool empty() const { return count == 0; }
+
+            T &operator[](std::size_t i) { return ptr[i]; }
+            const T &operator[](std::size_t i) const { return ptr[i]; }
+
+            T *begin() { return ptr; }
+            T *end() { return ptr + count; }
+            const T *begin() const { return ptr; }
+            const T *end() const { return ptr + count; }
+
+        private:
+            // The pointer returned by operator new is stashed right before the aligned block
+            static T *allocate(std::size_t n)
+            {
+                if (n == 0)
+                {
+                    return nullptr;
+                }
+                std::size_t bytes = n * sizeof(T);
+                void *raw = ::operator new(bytes + ALIGNMENT);
+                std::uintptr_t address = (reinterpret_cast<std::uintptr_t>(raw) + ALIGNMENT) & ~static_cast<std::uintptr_t>(ALIGNMENT - 1);
+                void *aligned = reinterpret_cast<void *>(address);
+                static_cast<void **>(aligned)[-1] = raw;
+                std::memset(aligned, 0, bytes);
+                return static_cast<T *>(aligned);
+            }
+
+            static void deallocate(T *p)
+            {
+                if (p != nullptr)
+                {
+                    ::operator delete(reinterpret_cast<void **>(p)[-1]);
+                }
+            }
+
+            T *ptr;
+            std::size_t count;
+            std::shared_ptr<void> owner; // null when ptr was allocated here
+    };
+
+} // namespace ariel
+
+#endif // ALIGNED_BUFFER_HPP
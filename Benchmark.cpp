@@ -0,0 +1,913 @@
+// Benchmarks for the graph library.
+// Usage: ./benchmark [name [size]]
+// Without arguments every benchmark runs at its default size.
+#include "Graph.hpp"
+#include "GraphIO.hpp"
+#include "Algorithms.hpp"
+#include "Kernels.hpp"
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+using namespace ariel;
+using namespace std;
+
+// Every allocation of the program goes through these counters. Blocks carry their size in a
+// header so that the bytes currently held, and their peak, can be tracked too.
+static size_t allocations = 0;
+static size_t bytesHeld = 0;
+static size_t peakBytesHeld = 0;
+static const size_t HEADER_BYTES = 16;
+
+void *operator new(size_t bytes)
+{
+    void *raw = malloc(bytes + HEADER_BYTES);
+    if (raw == nullptr)
+    {
+        throw bad_alloc();
+    }
+    *static_cast<size_t *>(raw) = bytes;
+    allocations++;
+    bytesHeld += bytes;
+    peakBytesHeld = max(peakBytesHeld, bytesHeld);
+    return static_cast<char *>(raw) + HEADER_BYTES;
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p != nullptr)
+    {
+        void *raw = static_cast<char *>(p) - HEADER_BYTES;
+        bytesHeld -= *static_cast<size_t *>(raw);
+        free(raw);
+    }
+}
+
+static double secondsSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Undirected path 0 - 1 - ... - (n-1)
+static Graph pathGraph(unsigned int n)
+{
+    vector<Edge> edges;
+    edges.reserve(2 * static_cast<size_t>(n));
+    for (unsigned int u = 0; u + 1 < n; ++u)
+    {
+        edges.push_back(Edge{u, u + 1, 1});
+        edges.push_back(Edge{u + 1, u, 1});
+    }
+    Graph g;
+    g.loadEdges(n, edges);
+    return g;
+}
+
+// The DFS engine on a path as deep as the graph; a recursive traversal overflows an 8 MB stack long before this
+static void benchDfsPath(unsigned int n)
+{
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Graph g = pathGraph(n);
+    cout << "  build path graph:  " << secondsSince(start) << " s" << endl;
+
+    start = chrono::steady_clock::now();
+    int connected = Algorithms::isConnected(g);
+    cout << "  isConnected:       " << secondsSince(start) << " s (result " << connected << ")" << endl;
+
+    start = chrono::steady_clock::now();
+    int cycle = Algorithms::isContainsCycle(g);
+    cout << "  isContainsCycle:   " << secondsSince(start) << " s (result " << cycle << ")" << endl;
+}
+
+// Undirected graph with about 4n random edges (average degree 8)
+static Graph randomGraph(unsigned int n, mt19937 &rng)
+{
+    vector<Edge> edges;
+    edges.reserve(8 * static_cast<size_t>(n));
+    for (size_t i = 0; i < 4 * static_cast<size_t>(n); ++i)
+    {
+        unsigned int u = static_cast<unsigned int>(rng() % n);
+        unsigned int v = static_cast<unsigned int>(rng() % n);
+        if (u != v)
+        {
+            edges.push_back(Edge{u, v, 1});
+            edges.push_back(Edge{v, u, 1});
+        }
+    }
+    Graph g;
+    g.loadEdges(n, edges);
+    return g;
+}
+
+// Undirected preferential attachment graph: every new vertex links to 4 endpoints picked
+// proportionally to their degree, which gives a power-law degree distribution
+static Graph powerLawGraph(unsigned int n, mt19937 &rng)
+{
+    const unsigned int links = 4;
+    vector<Edge> edges;
+    vector<unsigned int> endpoints;
+    edges.reserve(2 * links * static_cast<size_t>(n));
+    endpoints.reserve(2 * links * static_cast<size_t>(n));
+    for (unsigned int u = 1; u <= links && u < n; ++u)
+    {
+        edges.push_back(Edge{0, u, 1});
+        edges.push_back(Edge{u, 0, 1});
+        endpoints.push_back(0);
+        endpoints.push_back(u);
+    }
+    for (unsigned int u = links + 1; u < n; ++u)
+    {
+        for (unsigned int k = 0; k < links; ++k)
+        {
+            unsigned int v = endpoints[rng() % endpoints.size()];
+            if (v == u)
+            {
+                continue;
+            }
+            edges.push_back(Edge{u, v, 1});
+            edges.push_back(Edge{v, u, 1});
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+    Graph g;
+    g.loadEdges(n, edges);
+    return g;
+}
+
+// Runs the same random queries with plain and bidirectional BFS and compares the work done.
+// The graphs are undirected, so g is its own transpose.
+static void compareBreadthFirst(const Graph &g, mt19937 &rng)
+{
+    const unsigned int queries = 200;
+    vector<pair<unsigned int, unsigned int>> pairs;
+    for (unsigned int q = 0; q < queries; ++q)
+    {
+        pairs.push_back(make_pair(static_cast<unsigned int>(rng() % g.getNumVertices()), static_cast<unsigned int>(rng() % g.getNumVertices())));
+    }
+
+    size_t touched = 0;
+    Algorithms::setStatsHook([&touched](const AlgorithmStats &stats) { touched += stats.verticesVisited; });
+    const PathMethod methods[] = {PathMethod::BreadthFirst, PathMethod::Bidirectional};
+    const char *names[] = {"breadth-first", "bidirectional"};
+    for (int m = 0; m < 2; ++m)
+    {
+        touched = 0;
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (const pair<unsigned int, unsigned int> &query : pairs)
+        {
+            Algorithms::shortestPath(g, query.first, query.second, PathOptions(methods[m], &g));
+        }
+        double seconds = secondsSince(start);
+        cout << "  " << names[m] << ": " << touched / queries << " vertices touched per query, "
+             << seconds * 1e6 / queries << " us per query" << endl;
+    }
+    Algorithms::setStatsHook(nullptr);
+}
+
+static void benchBfsRandom(unsigned int n)
+{
+    mt19937 rng(1);
+    Graph g = randomGraph(n, rng);
+    compareBreadthFirst(g, rng);
+}
+
+static void benchBfsPowerLaw(unsigned int n)
+{
+    mt19937 rng(2);
+    Graph g = powerLawGraph(n, rng);
+    compareBreadthFirst(g, rng);
+}
+
+// Dense n x n matrix with small random weights and a zero diagonal
+static vector<vector<int>> randomMatrix(unsigned int n, mt19937 &rng)
+{
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            if (i != j)
+            {
+                matrix[i][j] = static_cast<int>(rng() % 7) - 3;
+            }
+        }
+    }
+    return matrix;
+}
+
+// The textbook i-j-k product over vector<vector<int>> that operator* started from
+static vector<vector<int>> multiplyTextbook(const vector<vector<int>> &a, const vector<vector<int>> &b)
+{
+    size_t n = a.size();
+    vector<vector<int>> c(n, vector<int>(n, 0));
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            for (size_t k = 0; k < n; ++k)
+            {
+                c[i][j] += a[i][k] * b[k][j];
+            }
+        }
+    }
+    return c;
+}
+
+// Billions of multiply-adds per second for an n x n product
+static double gigaOps(unsigned int n, double seconds)
+{
+    return 2.0 * n * n * n / seconds / 1e9;
+}
+
+static void benchMatmul(unsigned int n)
+{
+    mt19937 rng(3);
+    vector<vector<int>> a = randomMatrix(n, rng);
+    vector<vector<int>> b = randomMatrix(n, rng);
+    Graph ga, gb;
+    ga.loadGraph(a);
+    gb.loadGraph(b);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    vector<vector<int>> expected = multiplyTextbook(a, b);
+    double seconds = secondsSince(start);
+    cout << "  textbook i-j-k: " << seconds << " s, " << gigaOps(n, seconds) << " GOP/s" << endl;
+
+    start = chrono::steady_clock::now();
+    Graph product = ga * gb;
+    seconds = secondsSince(start);
+    cout << "  operator*:      " << seconds << " s, " << gigaOps(n, seconds) << " GOP/s" << endl;
+
+    bool same = true;
+    for (unsigned int i = 0; i < n && same; ++i)
+    {
+        for (unsigned int j = 0; j < n && same; ++j)
+        {
+            same = product.getWeight(i, j) == expected[i][j];
+        }
+    }
+    cout << "  results " << (same ? "match" : "DIFFER") << endl;
+}
+
+// The elementwise operators with every instruction set this CPU supports
+static void benchElementwise(unsigned int n)
+{
+    mt19937 rng(4);
+    Graph a, b;
+    a.loadGraph(randomMatrix(n, rng));
+    b.loadGraph(randomMatrix(n, rng));
+    const int rounds = 20;
+    const InstructionSet sets[] = {InstructionSet::Scalar, InstructionSet::SSE41, InstructionSet::AVX2};
+    const char *names[] = {"scalar", "sse4.1", "avx2"};
+    for (int s = 0; s < 3; ++s)
+    {
+        if (static_cast<int>(sets[s]) > static_cast<int>(Kernels::detect()))
+        {
+            continue;
+        }
+        Kernels::select(sets[s]);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (int r = 0; r < rounds; ++r)
+        {
+            a += b;
+            a -= b;
+            a *= 1;
+        }
+        double seconds = secondsSince(start) / (3 * rounds);
+        cout << "  " << names[s] << ": " << seconds * 1e3 << " ms per operator, "
+             << static_cast<double>(n) * n / seconds / 1e9 << " G entries/s" << endl;
+    }
+    Kernels::select(Kernels::detect());
+}
+
+// a + b - c * 2 evaluated as one expression, and one operator at a time through named temporaries
+static void benchExpression(unsigned int n)
+{
+    mt19937 rng(5);
+    Graph a, b, c;
+    a.loadGraph(randomMatrix(n, rng));
+    b.loadGraph(randomMatrix(n, rng));
+    c.loadGraph(randomMatrix(n, rng));
+    const int rounds = 10;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        Graph sum = a + b;
+        Graph scaled = c * 2;
+        Graph result = sum - scaled;
+    }
+    cout << "  one operator at a time: " << secondsSince(start) * 1e3 / rounds << " ms" << endl;
+
+    start = chrono::steady_clock::now();
+    for (int r = 0; r < rounds; ++r)
+    {
+        Graph result = a + b - c * 2;
+    }
+    cout << "  fused expression:       " << secondsSince(start) * 1e3 / rounds << " ms" << endl;
+}
+
+// Allocations and peak memory of a chain of operators whose left operand is a temporary,
+// with the temporary bound to a const reference (copying path) and used directly (in place)
+static void benchMoves(unsigned int n)
+{
+    mt19937 rng(6);
+    Graph a, b, c;
+    a.loadGraph(randomMatrix(n, rng));
+    b.loadGraph(randomMatrix(n, rng));
+    c.loadGraph(randomMatrix(n, rng));
+    const double mb = 1024.0 * 1024.0;
+
+    size_t before = allocations;
+    peakBytesHeld = bytesHeld;
+    size_t base = bytesHeld;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    {
+        const Graph &product = a * b;
+        Graph result = product + c - c * 2 + a;
+    }
+    cout << "  a * b + c - c * 2 + a, copying:  " << allocations - before << " allocations, peak "
+         << (peakBytesHeld - base) / mb << " MB, " << secondsSince(start) * 1e3 << " ms" << endl;
+
+    before = allocations;
+    peakBytesHeld = bytesHeld;
+    start = chrono::steady_clock::now();
+    {
+        Graph result = a * b + c - c * 2 + a;
+    }
+    cout << "  a * b + c - c * 2 + a, in place: " << allocations - before << " allocations, peak "
+         << (peakBytesHeld - base) / mb << " MB, " << secondsSince(start) * 1e3 << " ms" << endl;
+
+    vector<vector<int>> matrix = randomMatrix(n, rng);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        vector<vector<int>> input = matrix;
+        size_t held = bytesHeld;
+        Graph loaded;
+        if (pass == 0)
+        {
+            loaded.loadGraph(input);
+        }
+        else
+        {
+            loaded.loadGraph(std::move(input));
+        }
+        cout << (pass == 0 ? "  loadGraph(matrix):            " : "  loadGraph(std::move(matrix)): ")
+             << (static_cast<double>(bytesHeld) - static_cast<double>(held)) / mb << " MB more held after loading" << endl;
+    }
+}
+
+// Sorting graphs compares edge counts O(n log n) times; only the first query per graph scans it
+static void benchSort(unsigned int n)
+{
+    mt19937 rng(7);
+    vector<Graph> graphs(200);
+    for (Graph &g : graphs)
+    {
+        g.loadGraph(randomMatrix(n, rng));
+        g *= static_cast<int>(rng() % 2);
+    }
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        shuffle(graphs.begin(), graphs.end(), rng);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        sort(graphs.begin(), graphs.end());
+        cout << "  sort " << graphs.size() << " graphs: " << secondsSince(start) * 1e3 << " ms" << endl;
+    }
+}
+
+// Unweighted undirected bipartite graph (even and odd vertices, each possible edge present with probability 1/4),
+// stored as dense ints and as bits
+static void benchBitset(unsigned int n)
+{
+    mt19937 rng(8);
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (unsigned int v = u + 1; v < n; ++v)
+        {
+            if ((u + v) % 2 == 1 && rng() % 4 == 0)
+            {
+                matrix[u][v] = matrix[v][u] = 1;
+            }
+        }
+    }
+    const Representation layouts[] = {Representation::Dense, Representation::Bitset};
+    const char *names[] = {"dense ", "bitset"};
+    for (int l = 0; l < 2; ++l)
+    {
+        Graph g;
+        g.loadGraph(matrix);
+        g.setRepresentation(layouts[l]);
+        g.isSymmetric();
+
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        int connected = Algorithms::isConnected(g);
+        double connectedSeconds = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        string bipartite = Algorithms::isBipartite(g);
+        double bipartiteSeconds = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        size_t hops = 0;
+        for (unsigned int q = 0; q < 20; ++q)
+        {
+            PathResult result;
+            Algorithms::findPath(g, rng() % n, rng() % n, result, PathOptions(PathMethod::BreadthFirst));
+            hops += result.vertices.size();
+        }
+        double pathSeconds = secondsSince(start) / 20;
+
+        cout << "  " << names[l] << ": isConnected " << connectedSeconds * 1e3 << " ms (" << connected
+             << "), isBipartite " << bipartiteSeconds * 1e3 << " ms (" << bipartite.substr(0, 1)
+             << "), BFS path " << pathSeconds * 1e3 << " ms per query (" << hops << " vertices in total)" << endl;
+    }
+}
+
+// The three semiring products on one graph; the boolean one works on bit rows
+static void benchSemiring(unsigned int n)
+{
+    mt19937 rng(9);
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (unsigned int v = 0; v < n; ++v)
+        {
+            if (u != v && rng() % 16 == 0)
+            {
+                matrix[u][v] = 1 + static_cast<int>(rng() % 9);
+            }
+        }
+    }
+    Graph g;
+    g.loadGraph(matrix);
+    g.setRepresentation(Representation::Dense);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Graph times = g.product<PlusTimes>(g);
+    double seconds = secondsSince(start);
+    cout << "  (+,*):    " << seconds << " s, " << gigaOps(n, seconds) << " GOP/s" << endl;
+
+    start = chrono::steady_clock::now();
+    Graph minPlus = g.product<MinPlus>(g);
+    seconds = secondsSince(start);
+    cout << "  (min,+):  " << seconds << " s, " << gigaOps(n, seconds) << " GOP/s" << endl;
+
+    start = chrono::steady_clock::now();
+    Graph orAnd = g.product<OrAnd>(g);
+    seconds = secondsSince(start);
+    cout << "  (or,and): " << seconds << " s, " << gigaOps(n, seconds) << " GOP/s, "
+         << orAnd.getNumEdges() << " pairs within two edges" << endl;
+}
+
+// Walk counts of length 64 by repeated multiplication and by squaring
+static void benchPow(unsigned int n)
+{
+    mt19937 rng(10);
+    vector<vector<int>> matrix(n, vector<int>(n, 0));
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (unsigned int v = 0; v < n; ++v)
+        {
+            if (u != v && rng() % 8 == 0)
+            {
+                matrix[u][v] = 1;
+            }
+        }
+    }
+    Graph g;
+    g.loadGraph(matrix);
+    g.setRepresentation(Representation::Dense);
+    const unsigned int k = 64;
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Graph repeated = g;
+    for (unsigned int i = 1; i < k; ++i)
+    {
+        repeated = repeated * g;
+    }
+    double seconds = secondsSince(start);
+    cout << "  " << k - 1 << " products: " << seconds << " s" << endl;
+
+    size_t allocationsBefore = allocations;
+    start = chrono::steady_clock::now();
+    Graph squared = g.pow(k);
+    seconds = secondsSince(start);
+    cout << "  pow(" << k << "):     " << seconds << " s, " << allocations - allocationsBefore << " allocations, results "
+         << (squared == repeated ? "match" : "DIFFER") << endl;
+
+    start = chrono::steady_clock::now();
+    try
+    {
+        g.pow(k, Overflow::Throw);
+        cout << "  pow(" << k << ", Overflow::Throw): " << secondsSince(start) << " s" << endl;
+    }
+    catch (const overflow_error &)
+    {
+        cout << "  pow(" << k << ", Overflow::Throw): overflow detected after " << secondsSince(start) << " s" << endl;
+    }
+}
+
+// Blocked products against Strassen-Winograd with several leaf sizes, from 256 vertices up to n,
+// to locate the crossover (the size from which some leaf size always wins)
+static void benchStrassen(unsigned int n)
+{
+    mt19937 rng(11);
+    unsigned int cutoff = Graph::getStrassenCutoff();
+    const unsigned int leaves[] = {128, 256, 512, 1024};
+    unsigned int crossover = 0;
+    for (unsigned int size = 256; size <= n; size = size * 3 / 2 / 64 * 64)
+    {
+        vector<vector<int>> a = randomMatrix(size, rng);
+        Graph g;
+        g.loadGraph(a);
+
+        Graph::setStrassenCutoff(0);
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Graph blocked = g * g;
+        double blockedSeconds = secondsSince(start);
+        cout << "  " << size << ": blocked " << blockedSeconds << " s";
+
+        double best = blockedSeconds;
+        for (unsigned int leaf : leaves)
+        {
+            if (leaf >= size)
+            {
+                continue;
+            }
+            Graph::setStrassenCutoff(leaf);
+            start = chrono::steady_clock::now();
+            Graph strassen = g * g;
+            double seconds = secondsSince(start);
+            best = min(best, seconds);
+            cout << ", leaf " << leaf << " " << seconds << " s" << (strassen == blocked ? "" : " (DIFFERS)");
+        }
+        cout << endl;
+        if (best == blockedSeconds)
+        {
+            crossover = 0;
+        }
+        else if (crossover == 0)
+        {
+            crossover = size;
+        }
+    }
+    Graph::setStrassenCutoff(cutoff);
+    if (crossover != 0)
+    {
+        cout << "  Strassen-Winograd wins from " << crossover << " vertices (cutoff in use: " << cutoff << ")" << endl;
+    }
+    else
+    {
+        cout << "  no crossover up to " << n << " vertices (cutoff in use: " << cutoff << ")" << endl;
+    }
+}
+
+// Random graph with about perRow edges per vertex
+static vector<Edge> randomEdges(unsigned int n, unsigned int perRow, mt19937 &rng)
+{
+    vector<Edge> edges;
+    edges.reserve(static_cast<size_t>(n) * perRow);
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (unsigned int e = 0; e < perRow; ++e)
+        {
+            unsigned int v = rng() % n;
+            if (v != u)
+            {
+                edges.push_back(Edge{u, v, 1 + static_cast<int>(rng() % 5)});
+            }
+        }
+    }
+    return edges;
+}
+
+// Products of graphs with 1% density through the dense kernels and Gustavson's sparse product,
+// then sparse products of a graph 16 times larger with the same number of edges per vertex
+static void benchSpgemm(unsigned int n)
+{
+    mt19937 rng(12);
+    unsigned int perRow = max(1u, n / 100);
+    Graph a, b;
+    a.loadEdges(n, randomEdges(n, perRow, rng));
+    b.loadEdges(n, randomEdges(n, perRow, rng));
+    a.setRepresentation(Representation::Sparse);
+    b.setRepresentation(Representation::Sparse);
+    Graph denseA = a, denseB = b;
+    denseA.setRepresentation(Representation::Dense);
+    denseB.setRepresentation(Representation::Dense);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Graph dense = denseA * denseB;
+    double denseSeconds = secondsSince(start);
+    start = chrono::steady_clock::now();
+    Graph sparse = a * b;
+    double sparseSeconds = secondsSince(start);
+    cout << "  " << n << " vertices, " << a.getNumEdges() << " edges: dense " << denseSeconds << " s, sparse "
+         << sparseSeconds << " s (" << sparse.getNumEdges() << " entries, results " << (sparse == dense ? "match" : "DIFFER") << ")" << endl;
+
+    unsigned int large = 16 * n;
+    Graph c, d;
+    c.loadEdges(large, randomEdges(large, perRow, rng));
+    d.loadEdges(large, randomEdges(large, perRow, rng));
+    start = chrono::steady_clock::now();
+    Graph product = c * d;
+    cout << "  " << large << " vertices, " << c.getNumEdges() << " edges: sparse " << secondsSince(start) << " s ("
+         << product.getNumEdges() << " entries)" << endl;
+}
+
+// loadGraph of a dense and of a sparse n x n matrix, validated and trusted
+static void benchLoad(unsigned int n)
+{
+    mt19937 rng(13);
+    const unsigned int percents[] = {30, 1};
+    for (unsigned int percent : percents)
+    {
+        vector<vector<int>> matrix(n, vector<int>(n, 0));
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 100 < percent)
+                {
+                    matrix[u][v] = 1 + static_cast<int>(rng() % 9);
+                }
+            }
+        }
+        double gigabytes = static_cast<double>(n) * n * sizeof(int) / 1e9;
+        const Validation validations[] = {Validation::Checked, Validation::Trusted};
+        const char *names[] = {"checked", "trusted"};
+        for (int k = 0; k < 2; ++k)
+        {
+            Graph g;
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            g.loadGraph(matrix, validations[k]);
+            double seconds = secondsSince(start);
+            cout << "  " << percent << "% density, " << names[k] << ": " << seconds << " s, " << gigabytes / seconds
+                 << " GB/s (" << (g.getRepresentation() == Representation::Dense ? "dense" : "sparse") << ")" << endl;
+        }
+    }
+}
+
+// Binary files of a dense and of a sparse graph: save, open with and without the checksum, then
+// the first pass over the mapped weights, against loadGraph of the same matrix
+static void benchBinary(unsigned int n)
+{
+    mt19937 rng(14);
+    const char *path = "benchmark_graph.bin";
+    const unsigned int percents[] = {30, 1};
+    for (unsigned int percent : percents)
+    {
+        vector<vector<int>> matrix(n, vector<int>(n, 0));
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 100 < percent)
+                {
+                    matrix[u][v] = 1 + static_cast<int>(rng() % 9);
+                }
+            }
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Graph loaded;
+        loaded.loadGraph(matrix);
+        double loadSeconds = secondsSince(start);
+
+        start = chrono::steady_clock::now();
+        GraphIO::save(loaded, path);
+        double saveSeconds = secondsSince(start);
+        start = chrono::steady_clock::now();
+        Graph checked = GraphIO::open(path);
+        double checkedSeconds = secondsSince(start);
+        start = chrono::steady_clock::now();
+        Graph trusted = GraphIO::open(path, Validation::Trusted);
+        double trustedSeconds = secondsSince(start);
+        start = chrono::steady_clock::now();
+        long long sum = 0;
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (Neighbor next : trusted.neighbors(u))
+            {
+                sum += next.weight;
+            }
+        }
+        double scanSeconds = secondsSince(start);
+        cout << "  " << percent << "% density (" << (loaded.getRepresentation() == Representation::Dense ? "dense" : "sparse")
+             << "): loadGraph " << loadSeconds << " s, save " << saveSeconds << " s, open checked " << checkedSeconds
+             << " s, open trusted " << trustedSeconds << " s, first scan " << scanSeconds << " s (sum " << sum << ", "
+             << (checked == loaded ? "match" : "DIFFER") << ")" << endl;
+    }
+    remove(path);
+}
+
+// Parsing a text edge list of n vertices and 16 edges per vertex with readEdges, from a string stream,
+// a file descriptor and a mapped file split over the thread pool, against stream extraction into loadEdges
+static void benchEdgeList(unsigned int n)
+{
+    mt19937 rng(15);
+    vector<Edge> edges = randomEdges(n, 16, rng);
+    string text;
+    for (const Edge &edge : edges)
+    {
+        text += to_string(edge.from) + ' ' + to_string(edge.to) + ' ' + to_string(edge.weight) + '\n';
+    }
+    double megabytes = static_cast<double>(text.size()) / 1e6;
+    const char *path = "benchmark_edges.txt";
+    {
+        ofstream file(path, ios::binary);
+        file << text;
+    }
+
+    istringstream in(text);
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Graph parsed = GraphIO::readEdges(in, n);
+    double streamSeconds = secondsSince(start);
+
+    int fd = open(path, O_RDONLY);
+    start = chrono::steady_clock::now();
+    Graph read = GraphIO::readEdges(fd, n);
+    double fdSeconds = secondsSince(start);
+    close(fd);
+
+    start = chrono::steady_clock::now();
+    Graph mapped = GraphIO::readEdges(path, n);
+    double fileSeconds = secondsSince(start);
+    remove(path);
+
+    istringstream extraction(text);
+    start = chrono::steady_clock::now();
+    vector<Edge> extracted;
+    Edge edge;
+    while (extraction >> edge.from >> edge.to >> edge.weight)
+    {
+        extracted.push_back(edge);
+    }
+    Graph loaded;
+    loaded.loadEdges(n, extracted);
+    double extractionSeconds = secondsSince(start);
+
+    cout << "  " << megabytes << " MB, " << edges.size() << " edges: readEdges(istream) " << streamSeconds << " s ("
+         << megabytes / streamSeconds << " MB/s), readEdges(fd) " << fdSeconds << " s (" << megabytes / fdSeconds
+         << " MB/s), readEdges(path) " << fileSeconds << " s (" << megabytes / fileSeconds << " MB/s, "
+         << ThreadPool::instance().size() << " threads), operator>> " << extractionSeconds << " s (" << megabytes / extractionSeconds << " MB/s), results "
+         << (parsed == loaded && read == loaded && mapped == loaded ? "match" : "DIFFER") << endl;
+}
+
+// Matrix Market and DIMACS files of n vertices and 16 edges per vertex: writing with the buffered
+// formatter against ostream insertion of the same lines, then reading the files back
+static void benchMatrixMarket(unsigned int n)
+{
+    mt19937 rng(16);
+    Graph g;
+    g.loadEdges(n, randomEdges(n, 16, rng));
+    const char *path = "benchmark_graph.mtx";
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    GraphIO::writeMatrixMarket(g, path);
+    double writeSeconds = secondsSince(start);
+    ifstream written(path, ios::binary | ios::ate);
+    double megabytes = static_cast<double>(written.tellg()) / 1e6;
+
+    start = chrono::steady_clock::now();
+    Graph market = GraphIO::readMatrixMarket(path);
+    double readSeconds = secondsSince(start);
+
+    start = chrono::steady_clock::now();
+    {
+        ofstream file(path, ios::binary | ios::trunc);
+        file << "%%MatrixMarket matrix coordinate integer general\n";
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (Neighbor next : g.neighbors(u))
+            {
+                file << u + 1 << ' ' << next.vertex + 1 << ' ' << next.weight << '\n';
+            }
+        }
+    }
+    double insertionSeconds = secondsSince(start);
+
+    GraphIO::writeDimacs(g, path);
+    start = chrono::steady_clock::now();
+    Graph dimacs = GraphIO::readDimacs(path);
+    double dimacsSeconds = secondsSince(start);
+    remove(path);
+
+    cout << "  " << megabytes << " MB: write " << writeSeconds << " s (" << megabytes / writeSeconds << " MB/s), operator<< "
+         << insertionSeconds << " s (" << megabytes / insertionSeconds << " MB/s), read " << readSeconds << " s ("
+         << megabytes / readSeconds << " MB/s), DIMACS read " << dimacsSeconds << " s, results "
+         << (market == g && dimacs == g ? "match" : "DIFFER") << endl;
+}
+
+// operator<< of an n-vertex graph at 5% density, against inserting the same text one element at a
+// time, and in sparse mode
+static void benchOutput(unsigned int n)
+{
+    mt19937 rng(17);
+    Graph g;
+    g.loadEdges(n, randomEdges(n, n / 20, rng));
+    g.setRepresentation(Representation::Dense);
+
+    ostringstream buffered;
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    buffered << g;
+    double bufferedSeconds = secondsSince(start);
+
+    ostringstream inserted;
+    start = chrono::steady_clock::now();
+    inserted << "[";
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        const int *r = g.getRow(i);
+        inserted << (i == 0 ? "[" : ", [");
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            if (j != 0)
+            {
+                inserted << ", ";
+            }
+            inserted << r[j];
+        }
+        inserted << "]";
+    }
+    inserted << "]";
+    double insertedSeconds = secondsSince(start);
+
+    ostringstream triples;
+    start = chrono::steady_clock::now();
+    triples << sparse << g;
+    double sparseSeconds = secondsSince(start);
+
+    double megabytes = static_cast<double>(buffered.str().size()) / 1e6;
+    cout << "  " << megabytes << " MB: operator<< " << bufferedSeconds << " s (" << megabytes / bufferedSeconds
+         << " MB/s), element by element " << insertedSeconds << " s (" << megabytes / insertedSeconds << " MB/s, "
+         << (inserted.str() == buffered.str() ? "same" : "DIFFERENT") << " text), sparse mode " << sparseSeconds << " s ("
+         << static_cast<double>(triples.str().size()) / 1e6 << " MB)" << endl;
+}
+
+struct Benchmark
+{
+    const char *name;
+    void (*run)(unsigned int size);
+    unsigned int defaultSize;
+};
+
+static const Benchmark BENCHMARKS[] = {
+    {"dfs-path", benchDfsPath, 10000000},
+    {"bfs-random", benchBfsRandom, 1000000},
+    {"bfs-powerlaw", benchBfsPowerLaw, 1000000},
+    {"matmul", benchMatmul, 1024},
+    {"elementwise", benchElementwise, 4096},
+    {"expression", benchExpression, 4096},
+    {"moves", benchMoves, 2048},
+    {"sort", benchSort, 512},
+    {"bitset", benchBitset, 4096},
+    {"semiring", benchSemiring, 2048},
+    {"pow", benchPow, 512},
+    {"strassen", benchStrassen, 4096},
+    {"spgemm", benchSpgemm, 2048},
+    {"load", benchLoad, 8192},
+    {"binary", benchBinary, 8192},
+    {"edgelist", benchEdgeList, 200000},
+    {"mtx", benchMatrixMarket, 200000},
+    {"output", benchOutput, 2048},
+};
+
+int main(int argc, char **argv)
+{
+    const char *only = argc > 1 ? argv[1] : nullptr;
+    bool found = false;
+    for (const Benchmark &benchmark : BENCHMARKS)
+    {
+        if (only != nullptr && strcmp(only, benchmark.name) != 0)
+        {
+            continue;
+        }
+        found = true;
+        unsigned int size = argc > 2 ? static_cast<unsigned int>(strtoul(argv[2], nullptr, 10)) : benchmark.defaultSize;
+        cout << benchmark.name << " (size " << size << ")" << endl;
+        benchmark.run(size);
+    }
+    if (!found)
+    {
+        cerr << "Unknown benchmark: " << only << endl;
+        return 1;
+    }
+    return 0;
+}
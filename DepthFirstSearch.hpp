@@ -0,0 +1,133 @@
+#ifndef DEPTH_FIRST_SEARCH_HPP
+#define DEPTH_FIRST_SEARCH_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "Graph.hpp"
+
+namespace ariel {
+    // Callbacks of DepthFirstSearch::run; derive from this and hide the ones you need.
+    // Returning false from a bool callback stops the search.
+    struct DfsVisitor {
+        // u has just been reached (its parent is already set)
+        bool preVisit(unsigned int /*u*/) { return true; }
+
+        // The search is about to descend from u into next.vertex
+        bool treeEdge(unsigned int /*u*/, Neighbor /*next*/) { return true; }
+
+        // next.vertex had already been visited when the edge from u was examined
+        bool nonTreeEdge(unsigned int /*u*/, Neighbor /*next*/) { return true; }
+
+        // Every edge of u has been examined
+        void postVisit(unsigned int /*u*/) {}
+    };
+
+    // Iterative depth-first search over a Graph, in the same order as the recursive version.
+    // The explicit stack, visited bitmap and parent array are allocated once per engine,
+    // so runs never recurse and never allocate.
+    class DepthFirstSearch {
+        public:
+            static const unsigned int NO_PARENT = static_cast<unsigned int>(-1);
+
+            explicit DepthFirstSearch(const Graph &graph)
+                : graph(graph),
+                  visited((static_cast<std::size_t>(graph.getNumVertices()) + 63) / 64, 0),
+                  parent(graph.getNumVertices(), NO_PARENT)
+            {
+                stack.reserve(graph.getNumVertices());
+            }
+
+            // Visit every not yet visited vertex reachable from root.
+            // Returns false if a callback stopped the search.
+            template <typename Visitor>
+            bool run(unsigned int root, Visitor &visitor);
+
+            // Forget all visited vertices and parents
+            void reset()
+            {
+                std::fill(visited.begin(), visited.end(), 0);
+                std::fill(parent.begin(), parent.end(), NO_PARENT);
+            }
+
+            bool isVisited(unsigned int u) const
+            {
+                return (visited[u >> 6] >> (u & 63)) & 1;
+            }
+
+            // The vertex u was discovered from, or NO_PARENT for roots and unvisited vertices
+            unsigned int getParent(unsigned int u) const
+            {
+                return parent[u];
+            }
+
+        private:
+            // A vertex on the stack and where to resume scanning its neighbors
+            struct Frame {
+                unsigned int vertex;
+                unsigned int position;
+            };
+
+            void markVisited(unsigned int u)
+            {
+                visited[u >> 6] |= std::uint64_t(1) << (u & 63);
+            }
+
+            const Graph &graph;
+            std::vector<Frame> stack;
+            std::vector<std::uint64_t> visited;
+            std::vector<unsigned int> parent;
+    };
+
+    template <typename Visitor>
+    bool DepthFirstSearch::run(unsigned int root, Visitor &visitor)
+    {
+        markVisited(root);
+        parent[root] = NO_PARENT;
+        if (!visitor.preVisit(root))
+        {
+            return false;
+        }
+        stack.push_back(Frame{root, 0});
+
+        while (!stack.empty())
+        {
+            unsigned int u = stack.back().vertex;
+            NeighborRange range = graph.neighbors(u);
+            NeighborIterator end = range.end();
+            NeighborIterator it = range.at(stack.back().position);
+            for (; it != end; ++it)
+            {
+                Neighbor next = *it;
+                if (isVisited(next.vertex))
+                {
+                    if (!visitor.nonTreeEdge(u, next))
+                    {
+                        stack.clear();
+                        return false;
+                    }
+                    continue;
+                }
+                stack.back().position = static_cast<unsigned int>(it.position() + 1);
+                parent[next.vertex] = u;
+                markVisited(next.vertex);
+                if (!visitor.treeEdge(u, next) || !visitor.preVisit(next.vertex))
+                {
+                    stack.clear();
+                    return false;
+                }
+                stack.push_back(Frame{next.vertex, 0});
+                break;
+            }
+            if (it == end)
+            {
+                stack.pop_back();
+                visitor.postVisit(u);
+            }
+        }
+        return true;
+    }
+
+} // namespace ariel
+
+#endif // DEPTH_FIRST_SEARCH_HPP
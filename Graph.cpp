@@ -1,33 +1,1195 @@
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
 #include "Graph.hpp"
+#include "Kernels.hpp"
+#include "TextWriter.hpp"
+#include "ThreadPool.hpp"
 
 namespace ariel
 {
+    // Number of ints in one cache line
+    static const std::size_t INTS_PER_LINE = AlignedBuffer<int>::ALIGNMENT / sizeof(int);
+
+    // Smallest graph for which loadGraph/loadEdges will pick the sparse layout
+    static const unsigned int SPARSE_MIN_VERTICES = 64;
+
+    // The sparse layout is picked when at most 1/SPARSE_DENSITY_DIVISOR of the entries are non zero
+    static const std::size_t SPARSE_DENSITY_DIVISOR = 8;
+
+    static const std::size_t NO_ENTRY = static_cast<std::size_t>(-1);
+
+    // Rows per task when an adjacency matrix is loaded
+    static const unsigned int LOAD_ROWS = 256;
+
+    // Vertices per task in the row passes of loadEdges
+    static const unsigned int EDGE_ROWS = 4096;
+
+    // Blocking of the dense product: a K_BLOCK x COL_BLOCK panel of the right operand (256 KB)
+    // stays in L2 while the row blocks of the left operand, spread over the thread pool, stream past it
+    static const unsigned int ROW_BLOCK = 32;
+    static const unsigned int K_BLOCK = 128;
+    static const unsigned int COL_BLOCK = 512;
+
+    // ci[j] = ci[j] + aik * bk[j] in the semiring, for j < width
+    template <typename Semiring>
+    static void accumulateRow(int *ci, const int *bk, int aik, unsigned int width)
+    {
+        for (unsigned int j = 0; j < width; ++j)
+        {
+            ci[j] = Semiring::add(ci[j], Semiring::multiply(aik, bk[j]));
+        }
+    }
+
+    template <>
+    void accumulateRow<PlusTimes>(int *ci, const int *bk, int aik, unsigned int width)
+    {
+        Kernels::multiplyAdd(ci, bk, aik, width);
+    }
+
+    template <>
+    void accumulateRow<MinPlus>(int *ci, const int *bk, int aik, unsigned int width)
+    {
+        Kernels::minPlus(ci, bk, aik, width);
+    }
+
+    // 64-bit sums of the ordinary product, exact while no partial sum leaves the 64-bit range
+    template <typename Semiring>
+    static void accumulateRow(long long *ci, const int *bk, int aik, unsigned int width)
+    {
+        for (unsigned int j = 0; j < width; ++j)
+        {
+            ci[j] += static_cast<long long>(aik) * bk[j];
+        }
+    }
+
+    // 128-bit sums of the ordinary product, exact for any size: a term has at most 62 bits and
+    // there are fewer than 2^32 of them
+    template <typename Semiring>
+    static void accumulateRow(__int128 *ci, const int *bk, int aik, unsigned int width)
+    {
+        for (unsigned int j = 0; j < width; ++j)
+        {
+            ci[j] += static_cast<long long>(aik) * bk[j];
+        }
+    }
+
+    // Rows [iBegin, iEnd) of c += a * panel, where the panel is a depth x width block of the right operand
+    template <typename Semiring, typename Sum>
+    static void multiplyRows(const int *a, std::size_t aStride, const int *packed, Sum *c, std::size_t cStride,
+                             unsigned int iBegin, unsigned int iEnd, unsigned int depth, unsigned int width)
+    {
+        // i-k-j order: the inner loop runs over contiguous rows of the panel and of c
+        for (unsigned int i = iBegin; i < iEnd; ++i)
+        {
+            const int *ai = a + i * aStride;
+            Sum *ci = c + i * cStride;
+            for (unsigned int k = 0; k < depth; ++k)
+            {
+                int aik = ai[k];
+                if (aik == Semiring::zero())
+                {
+                    continue;
+                }
+                accumulateRow<Semiring>(ci, packed + k * width, aik, width);
+            }
+        }
+    }
+
+    // c += a * b for n x n row-major matrices with the given row strides; c must not overlap a or b
+    template <typename Semiring, typename Sum>
+    static void multiplyDense(const int *a, std::size_t aStride, const int *b, std::size_t bStride, Sum *c, std::size_t cStride,
+                              unsigned int n, AlignedBuffer<int> &panel)
+    {
+        if (panel.size() < static_cast<std::size_t>(K_BLOCK) * COL_BLOCK)
+        {
+            panel.reset(static_cast<std::size_t>(K_BLOCK) * COL_BLOCK);
+        }
+        unsigned int rowBlocks = (n + ROW_BLOCK - 1) / ROW_BLOCK;
+        for (unsigned int jj = 0; jj < n; jj += COL_BLOCK)
+        {
+            unsigned int width = std::min(COL_BLOCK, n - jj);
+            for (unsigned int kk = 0; kk < n; kk += K_BLOCK)
+            {
+                unsigned int depth = std::min(K_BLOCK, n - kk);
+
+                // Pack rows kk.. and columns jj.. of b next to each other
+                int *packed = panel.data();
+                for (unsigned int k = 0; k < depth; ++k)
+                {
+                    std::memcpy(packed + k * width, b + (kk + k) * bStride + jj, width * sizeof(int));
+                }
+
+                // Captured through one pointer, which std::function stores without allocating
+                struct PanelTask
+                {
+                    const int *a;
+                    std::size_t aStride;
+                    const int *packed;
+                    Sum *c;
+                    std::size_t cStride;
+                    unsigned int n, depth, width;
+                } task = {a + kk, aStride, packed, c + jj, cStride, n, depth, width};
+                const PanelTask *t = &task;
+                ThreadPool::instance().parallelFor(rowBlocks, [t](std::size_t block)
+                {
+                    unsigned int iBegin = static_cast<unsigned int>(block) * ROW_BLOCK;
+                    unsigned int iEnd = std::min(t->n, iBegin + ROW_BLOCK);
+                    multiplyRows<Semiring, Sum>(t->a, t->aStride, t->packed, t->c, t->cStride, iBegin, iEnd, t->depth, t->width);
+                });
+            }
+        }
+    }
+
+    // Products of more vertices than this use Strassen-Winograd (Graph::setStrassenCutoff)
+    static unsigned int strassenCutoff = 512;
+
+    // Rows per task in the quadrant additions of Strassen-Winograd
+    static const unsigned int COMBINE_ROWS = 64;
+
+    // Buffers of one product, kept by callers that run several
+    struct ProductScratch
+    {
+        AlignedBuffer<int> panel; // packed block of the right operand
+        AlignedBuffer<int> left, right, out; // operands and result padded for Strassen-Winograd
+        AlignedBuffer<int> arena; // temporaries of every level of the recursion
+    };
+
+    // In unsigned arithmetic, which wraps modulo 2^32 where int overflow would be undefined, so the
+    // quadrant sums always cancel back to the entries of the blocked product
+    template <bool Subtract>
+    static void combineRow(int *d, const int *a, const int *b, unsigned int h)
+    {
+        for (unsigned int j = 0; j < h; ++j)
+        {
+            unsigned int x = static_cast<unsigned int>(a[j]), y = static_cast<unsigned int>(b[j]);
+            d[j] = static_cast<int>(Subtract ? x - y : x + y);
+        }
+    }
+
+    // d = a + b or a - b for h x h blocks (d may be a or b), rows spread over the thread pool
+    template <bool Subtract>
+    static void combine(int *d, std::size_t dStride, const int *a, std::size_t aStride, const int *b, std::size_t bStride, unsigned int h)
+    {
+        struct CombineTask
+        {
+            int *d;
+            const int *a;
+            const int *b;
+            std::size_t dStride, aStride, bStride;
+            unsigned int h;
+        } task = {d, a, b, dStride, aStride, bStride, h};
+        const CombineTask *t = &task;
+        ThreadPool::instance().parallelFor((h + COMBINE_ROWS - 1) / COMBINE_ROWS, [t](std::size_t block)
+        {
+            unsigned int iBegin = static_cast<unsigned int>(block) * COMBINE_ROWS;
+            unsigned int iEnd = std::min(t->h, iBegin + COMBINE_ROWS);
+            for (unsigned int i = iBegin; i < iEnd; ++i)
+            {
+                combineRow<Subtract>(t->d + i * t->dStride, t->a + i * t->aStride, t->b + i * t->bStride, t->h);
+            }
+        });
+    }
+
+    // Temporaries of strassen() for h x h blocks: two half-size blocks on every level above the leaves
+    static std::size_t arenaSize(unsigned int h, unsigned int leaf)
+    {
+        std::size_t size = 0;
+        for (; h > leaf; h /= 2)
+        {
+            size += 2 * static_cast<std::size_t>(h / 2) * (h / 2);
+        }
+        return size;
+    }
+
+    // c = a * b for h x h blocks, h = leaf * 2^levels. Above leaf size the seven half-size products of
+    // Winograd's variant run in the order of Boyer, Dumas, Pernet and Zhou, which needs only the two
+    // temporaries x and y per level: c's quadrants hold the other intermediate results.
+    static void strassen(const int *a, std::size_t as, const int *b, std::size_t bs, int *c, std::size_t cs,
+                         unsigned int h, unsigned int leaf, int *arena, AlignedBuffer<int> &panel)
+    {
+        if (h <= leaf)
+        {
+            for (unsigned int i = 0; i < h; ++i)
+            {
+                std::fill(c + i * cs, c + i * cs + h, 0);
+            }
+            multiplyDense<PlusTimes>(a, as, b, bs, c, cs, h, panel);
+            return;
+        }
+        unsigned int q = h / 2;
+        const int *a11 = a, *a12 = a + q, *a21 = a + q * as, *a22 = a + q * as + q;
+        const int *b11 = b, *b12 = b + q, *b21 = b + q * bs, *b22 = b + q * bs + q;
+        int *c11 = c, *c12 = c + q, *c21 = c + q * cs, *c22 = c + q * cs + q;
+        int *x = arena;
+        int *y = arena + static_cast<std::size_t>(q) * q;
+        int *next = y + static_cast<std::size_t>(q) * q;
+
+        combine<true>(x, q, a11, as, a21, as, q);               // S3 = A11 - A21
+        combine<true>(y, q, b22, bs, b12, bs, q);               // T3 = B22 - B12
+        strassen(x, q, y, q, c21, cs, q, leaf, next, panel);    // P7 = S3 T3
+        combine<false>(x, q, a21, as, a22, as, q);              // S1 = A21 + A22
+        combine<true>(y, q, b12, bs, b11, bs, q);               // T1 = B12 - B11
+        strassen(x, q, y, q, c22, cs, q, leaf, next, panel);    // P5 = S1 T1
+        combine<true>(x, q, x, q, a11, as, q);                  // S2 = S1 - A11
+        combine<true>(y, q, b22, bs, y, q, q);                  // T2 = B22 - T1
+        strassen(x, q, y, q, c12, cs, q, leaf, next, panel);    // P6 = S2 T2
+        combine<true>(x, q, a12, as, x, q, q);                  // S4 = A12 - S2
+        strassen(x, q, b22, bs, c11, cs, q, leaf, next, panel); // P3 = S4 B22
+        strassen(a11, as, b11, bs, x, q, q, leaf, next, panel); // P1 = A11 B11
+        combine<false>(c12, cs, x, q, c12, cs, q);              // U2 = P1 + P6
+        combine<false>(c21, cs, c12, cs, c21, cs, q);           // U3 = U2 + P7
+        combine<false>(c12, cs, c12, cs, c22, cs, q);           // U4 = U2 + P5
+        combine<false>(c22, cs, c21, cs, c22, cs, q);           // C22 = U3 + P5
+        combine<false>(c12, cs, c12, cs, c11, cs, q);           // C12 = U4 + P3
+        combine<true>(y, q, y, q, b21, bs, q);                  // T4 = T2 - B21
+        strassen(a22, as, y, q, c11, cs, q, leaf, next, panel); // P4 = A22 T4
+        combine<true>(c21, cs, c21, cs, c11, cs, q);            // C21 = U3 - P4
+        strassen(a12, as, b21, bs, c11, cs, q, leaf, next, panel); // P2 = A12 B21
+        combine<false>(c11, cs, x, q, c11, cs, q);              // C11 = P1 + P2
+    }
+
+    // Copy an n x n matrix into the top left corner of a zeroed m x m one
+    static void padInto(AlignedBuffer<int> &padded, const int *values, unsigned int n, std::size_t stride, unsigned int m)
+    {
+        if (padded.size() < static_cast<std::size_t>(m) * m)
+        {
+            padded.reset(static_cast<std::size_t>(m) * m);
+        }
+        std::memset(padded.data(), 0, static_cast<std::size_t>(m) * m * sizeof(int));
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            std::memcpy(padded.data() + static_cast<std::size_t>(i) * m, values + i * stride, n * sizeof(int));
+        }
+    }
+
+    // c = a * b for n x n matrices sharing the row stride. Above the cutoff, the size is padded to
+    // leaf * 2^levels with the smallest leaf not larger than the cutoff, and Strassen-Winograd
+    // recurses down to the blocked kernel. Adding the quadrants modulo 2^32 keeps the result identical to it.
+    template <typename Semiring>
+    static void multiplySquare(const int *a, const int *b, int *c, unsigned int n, std::size_t stride, ProductScratch &scratch)
+    {
+        multiplyDense<Semiring>(a, stride, b, stride, c, stride, n, scratch.panel);
+    }
+
+    template <>
+    void multiplySquare<PlusTimes>(const int *a, const int *b, int *c, unsigned int n, std::size_t stride, ProductScratch &scratch)
+    {
+        if (n <= strassenCutoff || strassenCutoff == 0)
+        {
+            multiplyDense<PlusTimes>(a, stride, b, stride, c, stride, n, scratch.panel);
+            return;
+        }
+        unsigned int levels = 0;
+        unsigned int leaf = n;
+        while (leaf > strassenCutoff)
+        {
+            ++levels;
+            leaf = (n + (1u << levels) - 1) >> levels;
+        }
+        unsigned int m = leaf << levels;
+        std::size_t arena = arenaSize(m, leaf);
+        if (scratch.arena.size() < arena)
+        {
+            scratch.arena.reset(arena);
+        }
+        if (m == n)
+        {
+            strassen(a, stride, b, stride, c, stride, n, leaf, scratch.arena.data(), scratch.panel);
+            return;
+        }
+        padInto(scratch.left, a, n, stride, m);
+        padInto(scratch.right, b, n, stride, m);
+        if (scratch.out.size() < static_cast<std::size_t>(m) * m)
+        {
+            scratch.out.reset(static_cast<std::size_t>(m) * m);
+        }
+        strassen(scratch.left.data(), m, scratch.right.data(), m, scratch.out.data(), m, m, leaf, scratch.arena.data(), scratch.panel);
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            std::memcpy(c + i * stride, scratch.out.data() + static_cast<std::size_t>(i) * m, n * sizeof(int));
+        }
+    }
+
+    // Gustavson's sparse product works on CSR arrays
+    struct CsrView
+    {
+        const std::size_t *offsets;
+        const unsigned int *columns;
+        const int *values;
+    };
+
+    // Entries of the rows one task of the sparse product computed, in row order
+    struct SparseRows
+    {
+        std::vector<unsigned int> columns;
+        std::vector<int> values;
+    };
+
+    // A row of the sparse product with fewer than V / HASH_RATIO multiplications uses the hash
+    // accumulator, whose entries are sorted at the end of the row. Other rows use a dense one of
+    // V sums and a bitmap of the touched columns, read in order at a cost of V / 64 words per row.
+    // The ratio is where the two took the same time on random graphs of 32K to 1M vertices.
+    static const std::size_t HASH_RATIO = 1024;
+
+    // Sparse product tasks per thread, balanced by multiplications
+    static const unsigned int SPARSE_TASKS_PER_THREAD = 4;
+
+    static const unsigned int EMPTY_SLOT = std::numeric_limits<unsigned int>::max();
+
+    // Rows [begin, end) of a * b, appended to out; work[i] is the number of multiplications of row i.
+    // Sums are kept in unsigned arithmetic, which wraps modulo 2^32 like the dense kernels where int
+    // overflow would be undefined.
+    static void multiplySparseRows(const CsrView &a, const CsrView &b, unsigned int n, unsigned int begin, unsigned int end,
+                                   const std::size_t *work, std::size_t *rowCounts, SparseRows &out)
+    {
+        std::vector<unsigned int> dense;
+        std::vector<std::uint64_t> touched; // bitmap of the columns of dense in use
+        std::vector<unsigned int> keys;
+        std::vector<unsigned int> sums;
+        std::vector<std::uint64_t> packed;
+        for (unsigned int i = begin; i < end; ++i)
+        {
+            std::size_t before = out.columns.size();
+            if (work[i] == 0)
+            {
+                rowCounts[i] = 0;
+                continue;
+            }
+            if (work[i] * HASH_RATIO < n)
+            {
+                // Open addressing, at most half full
+                std::size_t capacity = 1;
+                while (capacity < 2 * work[i])
+                {
+                    capacity *= 2;
+                }
+                if (keys.size() < capacity)
+                {
+                    keys.resize(capacity);
+                    sums.resize(capacity);
+                }
+                std::fill(keys.begin(), keys.begin() + static_cast<std::ptrdiff_t>(capacity), EMPTY_SLOT);
+                std::size_t mask = capacity - 1;
+                for (std::size_t p = a.offsets[i]; p < a.offsets[i + 1]; ++p)
+                {
+                    unsigned int k = a.columns[p];
+                    unsigned int aik = static_cast<unsigned int>(a.values[p]);
+                    for (std::size_t q = b.offsets[k]; q < b.offsets[k + 1]; ++q)
+                    {
+                        unsigned int j = b.columns[q];
+                        std::size_t slot = (j * std::size_t(2654435761u)) & mask;
+                        while (keys[slot] != j && keys[slot] != EMPTY_SLOT)
+                        {
+                            slot = (slot + 1) & mask;
+                        }
+                        if (keys[slot] == EMPTY_SLOT)
+                        {
+                            keys[slot] = j;
+                            sums[slot] = 0;
+                        }
+                        sums[slot] += aik * static_cast<unsigned int>(b.values[q]);
+                    }
+                }
+
+                // Column in the high half and sum in the low half, so a plain sort orders the row
+                packed.clear();
+                for (std::size_t slot = 0; slot < capacity; ++slot)
+                {
+                    if (keys[slot] != EMPTY_SLOT && sums[slot] != 0)
+                    {
+                        packed.push_back(std::uint64_t(keys[slot]) << 32 | sums[slot]);
+                    }
+                }
+                std::sort(packed.begin(), packed.end());
+                for (std::uint64_t entry : packed)
+                {
+                    out.columns.push_back(static_cast<unsigned int>(entry >> 32));
+                    out.values.push_back(static_cast<int>(static_cast<std::uint32_t>(entry)));
+                }
+            }
+            else
+            {
+                if (dense.empty())
+                {
+                    dense.assign(n, 0);
+                    touched.assign((static_cast<std::size_t>(n) + 63) / 64, 0);
+                }
+                for (std::size_t p = a.offsets[i]; p < a.offsets[i + 1]; ++p)
+                {
+                    unsigned int k = a.columns[p];
+                    unsigned int aik = static_cast<unsigned int>(a.values[p]);
+                    for (std::size_t q = b.offsets[k]; q < b.offsets[k + 1]; ++q)
+                    {
+                        unsigned int j = b.columns[q];
+                        std::uint64_t bit = std::uint64_t(1) << (j % 64);
+                        if ((touched[j / 64] & bit) == 0)
+                        {
+                            touched[j / 64] |= bit;
+                            dense[j] = 0;
+                        }
+                        dense[j] += aik * static_cast<unsigned int>(b.values[q]);
+                    }
+                }
+                // Collect in column order, clearing the bitmap for the next row
+                for (std::size_t w = 0; w < touched.size(); ++w)
+                {
+                    for (std::uint64_t word = touched[w]; word != 0; word &= word - 1)
+                    {
+                        unsigned int j = static_cast<unsigned int>(w * 64 + static_cast<std::size_t>(__builtin_ctzll(word)));
+                        if (dense[j] != 0)
+                        {
+                            out.columns.push_back(j);
+                            out.values.push_back(static_cast<int>(dense[j]));
+                        }
+                    }
+                    touched[w] = 0;
+                }
+            }
+            rowCounts[i] = out.columns.size() - before;
+        }
+    }
+
+    // Dense weights as semiring values; the ordinary product uses them as they are
+    template <typename Semiring>
+    static const int *semiringValues(const int *weights, unsigned int n, std::size_t stride, AlignedBuffer<int> &buffer)
+    {
+        buffer.reset(n * stride);
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                buffer[i * stride + j] = Semiring::fromEntry(weights[i * stride + j], i == j);
+            }
+        }
+        return buffer.data();
+    }
+
+    template <>
+    const int *semiringValues<PlusTimes>(const int *weights, unsigned int, std::size_t, AlignedBuffer<int> &)
+    {
+        return weights;
+    }
+
+    // Fill c with the semiring zero before the product and turn the sums into graph entries after it
+    template <typename Semiring>
+    static void clearValues(int *c, unsigned int n, std::size_t stride)
+    {
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            std::fill(c + i * stride, c + i * stride + n, Semiring::zero());
+        }
+    }
+
+    template <typename Semiring>
+    static void storeEntries(int *c, unsigned int n, std::size_t stride)
+    {
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                c[i * stride + j] = Semiring::toEntry(c[i * stride + j], i == j);
+            }
+        }
+    }
+
+    template <>
+    void clearValues<PlusTimes>(int *, unsigned int, std::size_t) {}
+
+    template <>
+    void storeEntries<PlusTimes>(int *, unsigned int, std::size_t) {}
+
+    // Largest magnitude among the first n entries of each of the n rows
+    static long long largestMagnitude(const int *values, unsigned int n, std::size_t stride)
+    {
+        long long largest = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                largest = std::max(largest, std::abs(static_cast<long long>(values[i * stride + j])));
+            }
+        }
+        return largest;
+    }
+
+    // Store the exact sums of a checked power step, or throw if one does not fit in an int
+    template <typename Sum>
+    static void narrowPower(const Sum *wide, int *c, std::size_t count)
+    {
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            if (wide[i] < std::numeric_limits<int>::min() || wide[i] > std::numeric_limits<int>::max())
+            {
+                throw std::overflow_error("An entry of the matrix power does not fit in an int");
+            }
+            c[i] = static_cast<int>(wide[i]);
+        }
+    }
+
+    // c = a * b for Graph::pow. Checked products sum in 64 bits, or in 128 bits when the magnitudes
+    // of a and b allow a partial sum to leave the 64-bit range, so only the final entries are checked.
+    static void powerStep(const int *a, const int *b, int *c, unsigned int n, std::size_t stride, ProductScratch &scratch,
+                          AlignedBuffer<long long> &wide, AlignedBuffer<__int128> &exact, Overflow overflow)
+    {
+        if (overflow == Overflow::Wrap)
+        {
+            std::memset(c, 0, n * stride * sizeof(int));
+            multiplySquare<PlusTimes>(a, b, c, n, stride, scratch);
+            return;
+        }
+        unsigned long long bound = static_cast<unsigned long long>(largestMagnitude(a, n, stride)) *
+                                   static_cast<unsigned long long>(largestMagnitude(b, n, stride));
+        if (n == 0 || bound <= static_cast<unsigned long long>(std::numeric_limits<long long>::max()) / n)
+        {
+            std::memset(wide.data(), 0, n * stride * sizeof(long long));
+            multiplyDense<PlusTimes>(a, stride, b, stride, wide.data(), stride, n, scratch.panel);
+            narrowPower(wide.data(), c, n * stride);
+            return;
+        }
+        if (exact.size() < n * stride)
+        {
+            exact.reset(n * stride);
+        }
+        std::memset(exact.data(), 0, n * stride * sizeof(__int128));
+        multiplyDense<PlusTimes>(a, stride, b, stride, exact.data(), stride, n, scratch.panel);
+        narrowPower(exact.data(), c, n * stride);
+    }
+
+    // c |= b for words consecutive words
+    static void orRow(std::uint64_t *c, const std::uint64_t *b, std::size_t words)
+    {
+        for (std::size_t w = 0; w < words; ++w)
+        {
+            c[w] |= b[w];
+        }
+    }
+
     // Constructor
-    Graph::Graph() {}
+    Graph::Graph()
+        : numVertices(0), representation(Representation::Dense), stride(0), bitStride(0), bitWeight(0),
+          summary{true, 0, 0, 0}, symmetry(Symmetry::Symmetric) {}
 
     // Destructor
     Graph::~Graph() {}
 
+    Graph::Graph(const Graph &other) = default;
+
+    Graph &Graph::operator=(const Graph &other) = default;
+
+    Graph::Graph(Graph &&other) noexcept : Graph()
+    {
+        swap(other);
+    }
+
+    Graph &Graph::operator=(Graph &&other) noexcept
+    {
+        if (this != &other)
+        {
+            Graph moved(std::move(other));
+            swap(moved);
+        }
+        return *this;
+    }
+
+    void Graph::swap(Graph &other) noexcept
+    {
+        std::swap(numVertices, other.numVertices);
+        std::swap(representation, other.representation);
+        std::swap(stride, other.stride);
+        weights.swap(other.weights);
+        rowOffsets.swap(other.rowOffsets);
+        columnIndices.swap(other.columnIndices);
+        edgeWeights.swap(other.edgeWeights);
+        std::swap(bitStride, other.bitStride);
+        adjacencyBits.swap(other.adjacencyBits);
+        std::swap(bitWeight, other.bitWeight);
+        std::swap(summary, other.summary);
+        std::swap(symmetry, other.symmetry);
+    }
+
+    std::size_t Graph::strideFor(unsigned int numVertices)
+    {
+        return (static_cast<std::size_t>(numVertices) + INTS_PER_LINE - 1) / INTS_PER_LINE * INTS_PER_LINE;
+    }
+
+    Representation Graph::chooseRepresentation(unsigned int numVertices, std::size_t nonZeros)
+    {
+        if (numVertices < SPARSE_MIN_VERTICES)
+        {
+            return Representation::Dense;
+        }
+        std::size_t entries = static_cast<std::size_t>(numVertices) * numVertices;
+        return nonZeros * SPARSE_DENSITY_DIVISOR <= entries ? Representation::Sparse : Representation::Dense;
+    }
+
+    // Switch to an all-zero dense matrix of the given size
+    void Graph::resize(unsigned int numVertices)
+    {
+        invalidateMetadata();
+        this->numVertices = numVertices;
+        representation = Representation::Dense;
+        stride = strideFor(numVertices);
+        weights.reset(stride * numVertices);
+        rowOffsets.reset(0);
+        columnIndices.reset(0);
+        edgeWeights.reset(0);
+        bitStride = 0;
+        adjacencyBits.reset(0);
+    }
+
+    // Take over the given rows of strideFor(numVertices) ints each (they are left empty)
+    void Graph::setDense(unsigned int numVertices, AlignedBuffer<int> &values)
+    {
+        invalidateMetadata();
+        this->numVertices = numVertices;
+        representation = Representation::Dense;
+        stride = strideFor(numVertices);
+        weights.reset(0);
+        rowOffsets.reset(0);
+        columnIndices.reset(0);
+        edgeWeights.reset(0);
+        bitStride = 0;
+        adjacencyBits.reset(0);
+        weights.swap(values);
+    }
+
+    // Take over the given sparse arrays (they are left empty)
+    void Graph::setSparse(unsigned int numVertices, AlignedBuffer<std::size_t> &offsets, AlignedBuffer<unsigned int> &columns, AlignedBuffer<int> &values)
+    {
+        invalidateMetadata();
+        this->numVertices = numVertices;
+        representation = Representation::Sparse;
+        stride = 0;
+        weights.reset(0);
+        rowOffsets.reset(0);
+        columnIndices.reset(0);
+        edgeWeights.reset(0);
+        bitStride = 0;
+        adjacencyBits.reset(0);
+        rowOffsets.swap(offsets);
+        columnIndices.swap(columns);
+        edgeWeights.swap(values);
+    }
+
+    // Take over the given bit rows of (numVertices + 63) / 64 words each (they are left empty)
+    void Graph::setBits(unsigned int numVertices, AlignedBuffer<std::uint64_t> &bits, int weight)
+    {
+        invalidateMetadata();
+        this->numVertices = numVertices;
+        representation = Representation::Bitset;
+        stride = 0;
+        weights.reset(0);
+        rowOffsets.reset(0);
+        columnIndices.reset(0);
+        edgeWeights.reset(0);
+        bitStride = (static_cast<std::size_t>(numVertices) + 63) / 64;
+        adjacencyBits.reset(0);
+        adjacencyBits.swap(bits);
+        bitWeight = weight;
+    }
+
+    int *Graph::row(unsigned int u)
+    {
+        return weights.data() + u * stride;
+    }
+
+    // Position of the entry (u, v) in the sparse arrays, or NO_ENTRY
+    std::size_t Graph::findEntry(unsigned int u, unsigned int v) const
+    {
+        const unsigned int *first = columnIndices.data() + rowOffsets[u];
+        const unsigned int *last = columnIndices.data() + rowOffsets[u + 1];
+        const unsigned int *it = std::lower_bound(first, last, v);
+        if (it == last || *it != v)
+        {
+            return NO_ENTRY;
+        }
+        return static_cast<std::size_t>(it - columnIndices.data());
+    }
+
+    // Write the getNumVertices() weights of row u to out
+    void Graph::copyRow(unsigned int u, int *out) const
+    {
+        if (representation == Representation::Dense)
+        {
+            std::memcpy(out, getRow(u), numVertices * sizeof(int));
+            return;
+        }
+        std::fill(out, out + numVertices, 0);
+        for (Neighbor next : neighbors(u))
+        {
+            out[next.vertex] = next.weight;
+        }
+    }
+
+    void Graph::toDense()
+    {
+        if (representation == Representation::Dense)
+        {
+            return;
+        }
+        // Keep the old storage alive while the rows are filled from it
+        Graph old;
+        swap(old);
+
+        // Same entries in another layout, so the metadata carries over
+        resize(old.numVertices);
+        for (unsigned int u = 0; u < numVertices; ++u)
+        {
+            int *r = row(u);
+            for (Neighbor next : old.neighbors(u))
+            {
+                r[next.vertex] = next.weight;
+            }
+        }
+        summary = old.summary;
+        symmetry = old.symmetry;
+    }
+
+    // Remove the stored zeros from the sparse arrays, in place, so that neighbors() never sees them
+    void Graph::dropZeroEntries()
+    {
+        std::size_t out = 0;
+        std::size_t begin = 0;
+        for (unsigned int u = 0; u < numVertices; ++u)
+        {
+            std::size_t end = rowOffsets[u + 1];
+            for (std::size_t e = begin; e < end; ++e)
+            {
+                if (edgeWeights[e] != 0)
+                {
+                    columnIndices[out] = columnIndices[e];
+                    edgeWeights[out] = edgeWeights[e];
+                    out++;
+                }
+            }
+            begin = end;
+            rowOffsets[u + 1] = out;
+        }
+        if (out != edgeWeights.size())
+        {
+            AlignedBuffer<unsigned int> columns(out);
+            AlignedBuffer<int> values(out);
+            std::copy(columnIndices.begin(), columnIndices.begin() + out, columns.begin());
+            std::copy(edgeWeights.begin(), edgeWeights.begin() + out, values.begin());
+            columnIndices.swap(columns);
+            edgeWeights.swap(values);
+        }
+    }
+
+    void Graph::toSparse()
+    {
+        if (representation == Representation::Sparse)
+        {
+            return;
+        }
+        AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(numVertices) + 1);
+        for (unsigned int u = 0; u < numVertices; ++u)
+        {
+            std::size_t count = 0;
+            for (NeighborIterator it = neighbors(u).begin(); it != neighbors(u).end(); ++it)
+            {
+                count++;
+            }
+            offsets[u + 1] = offsets[u] + count;
+        }
+
+        AlignedBuffer<unsigned int> columns(offsets[numVertices]);
+        AlignedBuffer<int> values(offsets[numVertices]);
+        std::size_t e = 0;
+        for (unsigned int u = 0; u < numVertices; ++u)
+        {
+            for (Neighbor next : neighbors(u))
+            {
+                columns[e] = next.vertex;
+                values[e] = next.weight;
+                e++;
+            }
+        }
+
+        Summary keptSummary = summary;
+        Symmetry keptSymmetry = symmetry;
+        setSparse(numVertices, offsets, columns, values);
+        summary = keptSummary;
+        symmetry = keptSymmetry;
+    }
+
+    // Set the bits of the non-zero entries in rows of (numVertices + 63) / 64 zeroed words
+    void Graph::packBits(std::uint64_t *bits) const
+    {
+        if (representation == Representation::Bitset)
+        {
+            std::memcpy(bits, adjacencyBits.data(), adjacencyBits.size() * sizeof(std::uint64_t));
+            return;
+        }
+        std::size_t words = (static_cast<std::size_t>(numVertices) + 63) / 64;
+        for (unsigned int u = 0; u < numVertices; ++u)
+        {
+            std::uint64_t *r = bits + u * words;
+            for (Neighbor next : neighbors(u))
+            {
+                r[next.vertex / 64] |= std::uint64_t(1) << (next.vertex % 64);
+            }
+        }
+    }
+
+    void Graph::toBitset()
+    {
+        if (representation == Representation::Bitset)
+        {
+            return;
+        }
+        const Summary &current = summarize();
+        if (current.minWeight != current.maxWeight)
+        {
+            throw std::invalid_argument("The bitset representation needs all edge weights to be equal");
+        }
+        std::size_t words = (static_cast<std::size_t>(numVertices) + 63) / 64;
+        AlignedBuffer<std::uint64_t> bits(words * numVertices);
+        packBits(bits.data());
+
+        Summary keptSummary = summary;
+        Symmetry keptSymmetry = symmetry;
+        setBits(numVertices, bits, current.maxWeight);
+        summary = keptSummary;
+        symmetry = keptSymmetry;
+    }
+
+    // This graph if it is dense, otherwise a dense copy stored in scratch
+    const Graph &Graph::denseView(Graph &scratch) const
+    {
+        if (representation == Representation::Dense)
+        {
+            return *this;
+        }
+        scratch = *this;
+        scratch.toDense();
+        return scratch;
+    }
+
     // Load the graph from the adjacency matrix
-    void Graph::loadGraph(const std::vector<std::vector<int>> &adjacencyMatrix)
+    void Graph::loadGraph(const std::vector<std::vector<int>> &adjacencyMatrix, Validation validation)
+    {
+        loadRows(adjacencyMatrix, nullptr, validation);
+    }
+
+    void Graph::loadGraph(std::vector<std::vector<int>> &&adjacencyMatrix, Validation validation)
+    {
+        loadRows(adjacencyMatrix, &adjacencyMatrix, validation);
+        std::vector<std::vector<int>>().swap(adjacencyMatrix);
+    }
+
+    // Number of non-zero entries of a row and their range (an empty range for a zero row)
+    static std::size_t scanRow(const int *r, unsigned int n, int &minWeight, int &maxWeight)
+    {
+        std::size_t count = 0;
+        int low = std::numeric_limits<int>::max();
+        int high = std::numeric_limits<int>::min();
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            count += r[j] != 0;
+            low = std::min(low, r[j] != 0 ? r[j] : std::numeric_limits<int>::max());
+            high = std::max(high, r[j] != 0 ? r[j] : std::numeric_limits<int>::min());
+        }
+        minWeight = std::min(minWeight, low);
+        maxWeight = std::max(maxWeight, high);
+        return count;
+    }
+
+    // Validate the row sizes and the diagonal, count the entries of every row, then copy the rows
+    // into the layout the counts select. Each step runs over blocks of rows in the thread pool;
+    // when release is the matrix itself, each row is freed right after it is copied.
+    void Graph::loadRows(const std::vector<std::vector<int>> &adjacencyMatrix, std::vector<std::vector<int>> *release, Validation validation)
     {
         unsigned int num = adjacencyMatrix.size();
+        std::size_t blocks = (static_cast<std::size_t>(num) + LOAD_ROWS - 1) / LOAD_ROWS;
+        ThreadPool &pool = ThreadPool::instance();
+
+        if (validation == Validation::Checked)
+        {
+            // O(V): the first bad row of each block, so the error is the one a serial scan would report
+            std::vector<unsigned int> firstBad(blocks, num);
+            pool.parallelFor(blocks, [&](std::size_t block)
+            {
+                unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * LOAD_ROWS));
+                for (unsigned int i = static_cast<unsigned int>(block * LOAD_ROWS); i < end; i++)
+                {
+                    if (num != adjacencyMatrix[i].size() || adjacencyMatrix[i][i] != 0)
+                    {
+                        firstBad[block] = i;
+                        return;
+                    }
+                }
+            });
+            for (unsigned int i : firstBad)
+            {
+                if (i != num)
+                {
+                    throw std::invalid_argument(num != adjacencyMatrix[i].size() ? "Not square" : "Invalid values");
+                }
+            }
+        }
+
+        // The entries of row i are counted in offsets[i + 1]; the counts also give the summary for free
+        AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(num) + 1);
+        std::vector<int> minWeights(blocks, std::numeric_limits<int>::max());
+        std::vector<int> maxWeights(blocks, std::numeric_limits<int>::min());
+        pool.parallelFor(blocks, [&](std::size_t block)
+        {
+            unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * LOAD_ROWS));
+            for (unsigned int i = static_cast<unsigned int>(block * LOAD_ROWS); i < end; i++)
+            {
+                offsets[i + 1] = scanRow(adjacencyMatrix[i].data(), num, minWeights[block], maxWeights[block]);
+            }
+        });
         for (unsigned int i = 0; i < num; i++)
         {
-            if (num != adjacencyMatrix[i].size())
+            offsets[i + 1] += offsets[i];
+        }
+        std::size_t nonZeros = offsets[num];
+        int minWeight = std::numeric_limits<int>::max();
+        int maxWeight = std::numeric_limits<int>::min();
+        for (std::size_t block = 0; block < blocks; block++)
+        {
+            minWeight = std::min(minWeight, minWeights[block]);
+            maxWeight = std::max(maxWeight, maxWeights[block]);
+        }
+        Summary loaded = {true, nonZeros, nonZeros != 0 ? minWeight : 0, nonZeros != 0 ? maxWeight : 0};
+
+        if (chooseRepresentation(num, nonZeros) == Representation::Dense)
+        {
+            resize(num);
+            pool.parallelFor(blocks, [&](std::size_t block)
+            {
+                unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * LOAD_ROWS));
+                for (unsigned int i = static_cast<unsigned int>(block * LOAD_ROWS); i < end; i++)
+                {
+                    std::memcpy(row(i), adjacencyMatrix[i].data(), num * sizeof(int));
+                    if (release != nullptr)
+                    {
+                        std::vector<int>().swap((*release)[i]);
+                    }
+                }
+            });
+            summary = loaded;
+            return;
+        }
+
+        AlignedBuffer<unsigned int> columns(nonZeros);
+        AlignedBuffer<int> values(nonZeros);
+        pool.parallelFor(blocks, [&](std::size_t block)
+        {
+            unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * LOAD_ROWS));
+            for (unsigned int i = static_cast<unsigned int>(block * LOAD_ROWS); i < end; i++)
+            {
+                const int *r = adjacencyMatrix[i].data();
+                std::size_t e = offsets[i];
+                for (unsigned int j = 0; j < num; j++)
+                {
+                    if (r[j] != 0)
+                    {
+                        columns[e] = j;
+                        values[e] = r[j];
+                        e++;
+                    }
+                }
+                if (release != nullptr)
+                {
+                    std::vector<int>().swap((*release)[i]);
+                }
+            }
+        });
+        setSparse(num, offsets, columns, values);
+        summary = loaded;
+    }
+
+    void Graph::loadEdges(unsigned int num, const std::vector<Edge> &edges)
+    {
+        // Consecutive slices of the list, one per thread
+        std::size_t numParts = ThreadPool::instance().size();
+        std::size_t partSize = (edges.size() + numParts - 1) / numParts;
+        std::vector<std::pair<const Edge *, std::size_t>> parts;
+        for (std::size_t first = 0; first < edges.size(); first += partSize)
+        {
+            parts.push_back(std::make_pair(edges.data() + first, std::min(partSize, edges.size() - first)));
+        }
+        loadEdgeParts(num, parts);
+    }
+
+    // Parallel counting sort by source of the concatenated parts. Each part counts its sources, a pass
+    // over the vertices turns the counts into the first slot of each part in every row, and each part
+    // scatters its edges there, so every row holds its edges in input order. The rows are then sorted
+    // and deduplicated in place, and compacted if duplicates or zero weights were dropped.
+    void Graph::loadEdgeParts(unsigned int num, const std::vector<std::pair<const Edge *, std::size_t>> &parts)
+    {
+        ThreadPool &pool = ThreadPool::instance();
+        std::size_t numParts = parts.size();
+        std::size_t blocks = (static_cast<std::size_t>(num) + EDGE_ROWS - 1) / EDGE_ROWS;
+
+        // The first bad edge of each part, so the error is the one a serial scan would report
+        std::vector<const Edge *> firstBad(numParts, nullptr);
+        std::vector<AlignedBuffer<std::size_t>> counts(numParts);
+        pool.parallelFor(numParts, [&](std::size_t p)
+        {
+            AlignedBuffer<std::size_t> &count = counts[p];
+            count.reset(num);
+            const Edge *edges = parts[p].first;
+            for (std::size_t i = 0; i < parts[p].second; ++i)
+            {
+                const Edge &edge = edges[i];
+                if (edge.from >= num || edge.to >= num || (edge.from == edge.to && edge.weight != 0))
+                {
+                    firstBad[p] = &edge;
+                    return;
+                }
+                count[edge.from] += edge.weight != 0;
+            }
+        });
+        for (const Edge *bad : firstBad)
+        {
+            if (bad != nullptr)
+            {
+                throw std::invalid_argument(bad->from >= num || bad->to >= num ? "Edge endpoint out of range" : "Invalid values");
+            }
+        }
+
+        AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(num) + 1);
+        pool.parallelFor(blocks, [&](std::size_t block)
+        {
+            unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * EDGE_ROWS));
+            for (unsigned int u = static_cast<unsigned int>(block * EDGE_ROWS); u < end; ++u)
+            {
+                std::size_t size = 0;
+                for (std::size_t p = 0; p < numParts; ++p)
+                {
+                    std::size_t count = counts[p][u];
+                    counts[p][u] = size;
+                    size += count;
+                }
+                offsets[u + 1] = size;
+            }
+        });
+        for (unsigned int u = 0; u < num; ++u)
+        {
+            offsets[u + 1] += offsets[u];
+        }
+
+        AlignedBuffer<unsigned int> columns(offsets[num]);
+        AlignedBuffer<int> values(offsets[num]);
+        pool.parallelFor(numParts, [&](std::size_t p)
+        {
+            AlignedBuffer<std::size_t> &next = counts[p];
+            const Edge *edges = parts[p].first;
+            for (std::size_t i = 0; i < parts[p].second; ++i)
+            {
+                const Edge &edge = edges[i];
+                if (edge.weight != 0)
+                {
+                    std::size_t pos = offsets[edge.from] + next[edge.from]++;
+                    columns[pos] = edge.to;
+                    values[pos] = edge.weight;
+                }
+            }
+        });
+        std::vector<AlignedBuffer<std::size_t>>().swap(counts);
+
+        // Sort every row by column and keep only the last of equal columns; rows that are already
+        // strictly increasing are left alone. The entries row u keeps are counted in kept[u + 1].
+        AlignedBuffer<std::size_t> kept(static_cast<std::size_t>(num) + 1);
+        pool.parallelFor(blocks, [&](std::size_t block)
+        {
+            std::vector<std::uint64_t> keys; // column << 32 | position in the row
+            std::vector<int> rowValues;
+            unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * EDGE_ROWS));
+            for (unsigned int u = static_cast<unsigned int>(block * EDGE_ROWS); u < end; ++u)
             {
-                throw std::invalid_argument("Not square");
+                std::size_t first = offsets[u];
+                std::size_t size = offsets[u + 1] - first;
+                std::size_t e = 1;
+                while (e < size && columns[first + e] > columns[first + e - 1])
+                {
+                    ++e;
+                }
+                if (e >= size)
+                {
+                    kept[u + 1] = size;
+                    continue;
+                }
+                keys.clear();
+                for (e = 0; e < size; ++e)
+                {
+                    keys.push_back(static_cast<std::uint64_t>(columns[first + e]) << 32 | e);
+                }
+                rowValues.assign(values.begin() + first, values.begin() + first + size);
+                std::sort(keys.begin(), keys.end());
+                std::size_t out = first;
+                for (std::size_t k = 0; k < size; ++k)
+                {
+                    if (k + 1 < size && keys[k + 1] >> 32 == keys[k] >> 32)
+                    {
+                        continue;
+                    }
+                    columns[out] = static_cast<unsigned int>(keys[k] >> 32);
+                    values[out] = rowValues[keys[k] & 0xffffffffu];
+                    out++;
+                }
+                kept[u + 1] = out - first;
             }
-            for (unsigned int j = 0; j < num; j++)
+        });
+        for (unsigned int u = 0; u < num; ++u)
+        {
+            kept[u + 1] += kept[u];
+        }
+
+        if (kept[num] != columns.size())
+        {
+            AlignedBuffer<unsigned int> exactColumns(kept[num]);
+            AlignedBuffer<int> exactValues(kept[num]);
+            pool.parallelFor(blocks, [&](std::size_t block)
             {
-                if (j == i && adjacencyMatrix[i][j] != 0)
+                unsigned int end = static_cast<unsigned int>(std::min<std::size_t>(num, (block + 1) * EDGE_ROWS));
+                for (unsigned int u = static_cast<unsigned int>(block * EDGE_ROWS); u < end; ++u)
                 {
-                    throw std::invalid_argument("Invalid values");
+                    std::size_t size = kept[u + 1] - kept[u];
+                    std::copy(columns.begin() + offsets[u], columns.begin() + offsets[u] + size, exactColumns.begin() + kept[u]);
+                    std::copy(values.begin() + offsets[u], values.begin() + offsets[u] + size, exactValues.begin() + kept[u]);
                 }
-            }
+            });
+            columns.swap(exactColumns);
+            values.swap(exactValues);
+        }
+        std::size_t entries = kept[num];
+        setSparse(num, kept, columns, values);
+
+        if (chooseRepresentation(num, entries) == Representation::Dense)
+        {
+            toDense();
+        }
+    }
+
+    Representation Graph::getRepresentation() const
+    {
+        return representation;
+    }
+
+    void Graph::setRepresentation(Representation representation)
+    {
+        if (representation == Representation::Dense)
+        {
+            toDense();
+        }
+        else if (representation == Representation::Sparse)
+        {
+            toSparse();
+        }
+        else
+        {
+            toBitset();
         }
-        this->adjacencyMatrix = adjacencyMatrix;
     }
 
     void Graph::printGraph() const
@@ -39,152 +1201,331 @@ namespace ariel
 
     unsigned int Graph::getNumVertices() const
     {
-        return adjacencyMatrix.size();
+        return numVertices;
     }
 
-    int Graph::getNumEdges() const
+    // Count the non-zero entries and their range, unless nothing changed since the last time
+    const Graph::Summary &Graph::summarize() const
     {
-        int count = 0;
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); ++i)
+        if (summary.known)
+        {
+            return summary;
+        }
+        if (representation == Representation::Bitset)
         {
-            for (unsigned int j = 0; j < adjacencyMatrix[i].size(); ++j)
+            std::size_t edges = 0;
+            for (std::uint64_t word : adjacencyBits)
             {
-                if (adjacencyMatrix[i][j] != 0)
-                {
-                    count++;
-                }
+                edges += static_cast<std::size_t>(__builtin_popcountll(word));
+            }
+            summary = Summary{true, edges, edges != 0 ? bitWeight : 0, edges != 0 ? bitWeight : 0};
+            return summary;
+        }
+        // Padding is zero, so the whole dense buffer can be scanned in one sweep
+        const AlignedBuffer<int> &values = representation == Representation::Dense ? weights : edgeWeights;
+        std::size_t nonZeros = 0;
+        int minWeight = std::numeric_limits<int>::max();
+        int maxWeight = std::numeric_limits<int>::min();
+        for (int w : values)
+        {
+            if (w != 0)
+            {
+                nonZeros++;
+                minWeight = std::min(minWeight, w);
+                maxWeight = std::max(maxWeight, w);
             }
         }
-        return count / 2;
+        summary.known = true;
+        summary.nonZeros = nonZeros;
+        summary.minWeight = nonZeros != 0 ? minWeight : 0;
+        summary.maxWeight = nonZeros != 0 ? maxWeight : 0;
+        return summary;
+    }
+
+    void Graph::invalidateMetadata()
+    {
+        summary.known = false;
+        symmetry = Symmetry::Unknown;
+    }
+
+    int Graph::getNumEdges() const
+    {
+        return static_cast<int>(summarize().nonZeros / 2);
+    }
+
+    int Graph::getMinWeight() const
+    {
+        return summarize().minWeight;
+    }
+
+    int Graph::getMaxWeight() const
+    {
+        return summarize().maxWeight;
+    }
+
+    bool Graph::hasNegativeWeight() const
+    {
+        return summarize().minWeight < 0;
     }
 
     bool Graph::containsEdge(unsigned int u, unsigned int v) const
     {
-        if (adjacencyMatrix[u][v] != 0)
+        if (representation == Representation::Sparse)
         {
-            return true;
+            return findEntry(u, v) != NO_ENTRY;
         }
-        return false;
+        if (representation == Representation::Bitset)
+        {
+            return (adjacencyBits[u * bitStride + v / 64] >> (v % 64) & 1) != 0;
+        }
+        return getRow(u)[v] != 0;
     }
 
     unsigned int *Graph::getNeighbors(unsigned int u, unsigned int &size) const
     {
+        NeighborRange range = neighbors(u);
         unsigned int neighborsCount = 0;
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); i++)
+        for (NeighborIterator it = range.begin(); it != range.end(); ++it)
         {
-            if (containsEdge(u, i))
-            {
-                neighborsCount++;
-            }
+            neighborsCount++;
         }
 
-        unsigned int *neighbors = new unsigned int[neighborsCount];
+        unsigned int *result = new unsigned int[neighborsCount];
         size = 0;
-        for (unsigned int i = 0; i < adjacencyMatrix.size() && size != neighborsCount; i++)
+        for (Neighbor next : range)
         {
-            if (containsEdge(u, i))
-            {
-                neighbors[size] = i;
-                size++;
-            }
+            result[size] = next.vertex;
+            size++;
         }
-        return neighbors;
+        return result;
     }
 
     int Graph::getWeight(unsigned int u, unsigned int v) const
     {
-        return adjacencyMatrix[u][v];
+        if (representation == Representation::Sparse)
+        {
+            std::size_t e = findEntry(u, v);
+            return e == NO_ENTRY ? 0 : edgeWeights[e];
+        }
+        if (representation == Representation::Bitset)
+        {
+            return containsEdge(u, v) ? bitWeight : 0;
+        }
+        return getRow(u)[v];
+    }
+
+    std::size_t Graph::getRowStride() const
+    {
+        return stride;
     }
 
-    // Arithmetic operators
-    Graph Graph::operator+(const Graph &other) const
+    const int *Graph::getRow(unsigned int u) const
     {
-        if (getNumVertices() != other.getNumVertices())
+        if (representation != Representation::Dense)
         {
-            throw std::invalid_argument("Graphs must be of the same size.");
-        }
-        Graph result = *this;
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); ++i)
-        {
-            for (unsigned int j = 0; j < adjacencyMatrix[i].size(); ++j)
-            {
-                result.adjacencyMatrix[i][j] += other.adjacencyMatrix[i][j];
-            }
+            throw std::logic_error("Row access requires the dense representation");
         }
-        return result;
+        return weights.data() + u * stride;
     }
 
-    Graph &Graph::operator+=(const Graph &other)
+    std::size_t Graph::getBitRowStride() const
     {
-        if (getNumVertices() != other.getNumVertices())
+        return bitStride;
+    }
+
+    const std::uint64_t *Graph::getBitRow(unsigned int u) const
+    {
+        if (representation != Representation::Bitset)
         {
-            throw std::invalid_argument("Graphs must be of the same size.");
+            throw std::logic_error("Bit row access requires the bitset representation");
         }
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); ++i)
+        return adjacencyBits.data() + u * bitStride;
+    }
+
+    int Graph::getBitWeight() const
+    {
+        return bitWeight;
+    }
+
+    bool Graph::isSymmetric() const
+    {
+        if (symmetry == Symmetry::Unknown)
         {
-            for (unsigned int j = 0; j < adjacencyMatrix[i].size(); ++j)
+            symmetry = Symmetry::Symmetric;
+            if (representation != Representation::Dense)
+            {
+                for (unsigned int u = 0; u < numVertices && symmetry == Symmetry::Symmetric; ++u)
+                {
+                    for (Neighbor next : neighbors(u))
+                    {
+                        if (getWeight(next.vertex, u) != next.weight)
+                        {
+                            symmetry = Symmetry::Asymmetric;
+                            break;
+                        }
+                    }
+                }
+            }
+            else
             {
-                adjacencyMatrix[i][j] += other.adjacencyMatrix[i][j];
+                for (unsigned int u = 0; u < numVertices && symmetry == Symmetry::Symmetric; ++u)
+                {
+                    const int *r = getRow(u);
+                    for (unsigned int v = u + 1; v < numVertices; ++v)
+                    {
+                        if (r[v] != weights[v * stride + u])
+                        {
+                            symmetry = Symmetry::Asymmetric;
+                            break;
+                        }
+                    }
+                }
             }
         }
-        return *this;
+        return symmetry == Symmetry::Symmetric;
     }
 
-    Graph Graph::operator-(const Graph &other) const
+    Graph Graph::transpose() const
     {
-        if (getNumVertices() != other.getNumVertices())
+        Graph result;
+        if (representation == Representation::Bitset)
         {
-            throw std::invalid_argument("Graphs must be of the same size.");
+            AlignedBuffer<std::uint64_t> bits(adjacencyBits.size());
+            for (unsigned int u = 0; u < numVertices; ++u)
+            {
+                for (Neighbor next : neighbors(u))
+                {
+                    bits[next.vertex * bitStride + u / 64] |= std::uint64_t(1) << (u % 64);
+                }
+            }
+            result.setBits(numVertices, bits, bitWeight);
+            result.summary = summary;
+            result.symmetry = symmetry;
+            return result;
+        }
+        if (representation == Representation::Sparse)
+        {
+            // Counting sort by column; scanning rows in order keeps every new row sorted
+            AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(numVertices) + 1);
+            for (unsigned int v : columnIndices)
+            {
+                offsets[v + 1]++;
+            }
+            for (unsigned int v = 0; v < numVertices; ++v)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+            AlignedBuffer<unsigned int> columns(columnIndices.size());
+            AlignedBuffer<int> values(edgeWeights.size());
+            std::vector<std::size_t> next(offsets.begin(), offsets.end() - 1);
+            for (unsigned int u = 0; u < numVertices; ++u)
+            {
+                for (std::size_t e = rowOffsets[u]; e < rowOffsets[u + 1]; ++e)
+                {
+                    std::size_t pos = next[columnIndices[e]]++;
+                    columns[pos] = u;
+                    values[pos] = edgeWeights[e];
+                }
+            }
+            result.setSparse(numVertices, offsets, columns, values);
+            result.summary = summary;
+            result.symmetry = symmetry;
+            return result;
         }
-        Graph result = *this;
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); ++i)
+
+        // Copy in square tiles so both the reads and the writes stay within a few cache lines
+        result.resize(numVertices);
+        for (unsigned int ii = 0; ii < numVertices; ii += INTS_PER_LINE)
         {
-            for (unsigned int j = 0; j < adjacencyMatrix[i].size(); ++j)
+            unsigned int iEnd = std::min<unsigned int>(ii + INTS_PER_LINE, numVertices);
+            for (unsigned int jj = 0; jj < numVertices; jj += INTS_PER_LINE)
             {
-                result.adjacencyMatrix[i][j] -= other.adjacencyMatrix[i][j];
+                unsigned int jEnd = std::min<unsigned int>(jj + INTS_PER_LINE, numVertices);
+                for (unsigned int i = ii; i < iEnd; ++i)
+                {
+                    const int *r = getRow(i);
+                    for (unsigned int j = jj; j < jEnd; ++j)
+                    {
+                        result.weights[j * stride + i] = r[j];
+                    }
+                }
             }
         }
+        // Reversing the edges keeps their weights and the symmetry
+        result.summary = summary;
+        result.symmetry = symmetry;
         return result;
     }
 
-    Graph &Graph::operator-=(const Graph &other)
+    // Arithmetic operators
+    // Sparse operands are expanded to dense; the results of these operators are dense
+    Graph &Graph::operator+=(const Graph &other)
     {
         if (getNumVertices() != other.getNumVertices())
         {
             throw std::invalid_argument("Graphs must be of the same size.");
         }
-        for (unsigned int i = 0; i < adjacencyMatrix.size(); ++i)
-        {
-            for (unsigned int j = 0; j < adjacencyMatrix[i].size(); ++j)
-            {
-                adjacencyMatrix[i][j] -= other.adjacencyMatrix[i][j];
-            }
-        }
+        toDense();
+        invalidateMetadata();
+        Graph scratch;
+        const int *src = other.denseView(scratch).weights.data();
+        Kernels::add(weights.data(), src, weights.size());
         return *this;
     }
 
-    Graph Graph::operator+() const
+    Graph &Graph::operator-=(const Graph &other)
     {
+        if (getNumVertices() != other.getNumVertices())
+        {
+            throw std::invalid_argument("Graphs must be of the same size.");
+        }
+        toDense();
+        invalidateMetadata();
+        Graph scratch;
+        const int *src = other.denseView(scratch).weights.data();
+        Kernels::subtract(weights.data(), src, weights.size());
         return *this;
     }
 
-    Graph Graph::operator-() const
+    Graph Graph::operator+() const
     {
-        Graph result = *this;
-        for (auto &row : result.adjacencyMatrix)
-        {
-            for (auto &val : row)
-            {
-                val = -val;
-            }
-        }
-        return result;
+        return *this;
     }
 
     // Comparison operators
     bool Graph::operator==(const Graph &other) const
     {
-        return adjacencyMatrix == other.adjacencyMatrix;
+        if (numVertices != other.numVertices)
+        {
+            return false;
+        }
+        // Different summaries settle most comparisons without touching the weights
+        const Summary &mine = summarize();
+        const Summary &theirs = other.summarize();
+        if (mine.nonZeros != theirs.nonZeros || mine.minWeight != theirs.minWeight || mine.maxWeight != theirs.maxWeight)
+        {
+            return false;
+        }
+        if (mine.nonZeros == 0)
+        {
+            return true;
+        }
+        if (representation == Representation::Bitset && other.representation == Representation::Bitset)
+        {
+            return std::equal(adjacencyBits.begin(), adjacencyBits.end(), other.adjacencyBits.begin());
+        }
+        if (representation == Representation::Sparse && other.representation == Representation::Sparse)
+        {
+            return std::equal(rowOffsets.begin(), rowOffsets.end(), other.rowOffsets.begin()) &&
+                   std::equal(columnIndices.begin(), columnIndices.end(), other.columnIndices.begin()) &&
+                   std::equal(edgeWeights.begin(), edgeWeights.end(), other.edgeWeights.begin());
+        }
+        // Equal sizes imply equal strides, and the padding is zero on both sides
+        Graph scratchA;
+        Graph scratchB;
+        const Graph &a = denseView(scratchA);
+        const Graph &b = other.denseView(scratchB);
+        return a.weights.empty() || std::memcmp(a.weights.data(), b.weights.data(), a.weights.size() * sizeof(int)) == 0;
     }
 
     bool Graph::operator!=(const Graph &other) const
@@ -194,7 +1535,7 @@ namespace ariel
 
     bool Graph::operator<(const Graph &other) const
     {
-        if (adjacencyMatrix == other.adjacencyMatrix)
+        if (*this == other)
         {
             return false;
         }
@@ -218,14 +1559,14 @@ namespace ariel
     }
 
     // Increment and decrement operators
+    // These touch zero entries too, so they expand sparse graphs and walk the rows to leave the padding alone
     Graph &Graph::operator++()
     {
-        for (auto &row : adjacencyMatrix)
+        toDense();
+        invalidateMetadata();
+        for (unsigned int i = 0; i < numVertices; ++i)
         {
-            for (auto &val : row)
-            {
-                ++val;
-            }
+            Kernels::addScalar(row(i), 1, numVertices);
         }
         return *this;
     }
@@ -239,12 +1580,11 @@ namespace ariel
 
     Graph &Graph::operator--()
     {
-        for (auto &row : adjacencyMatrix)
+        toDense();
+        invalidateMetadata();
+        for (unsigned int i = 0; i < numVertices; ++i)
         {
-            for (auto &val : row)
-            {
-                --val;
-            }
+            Kernels::addScalar(row(i), -1, numVertices);
         }
         return *this;
     }
@@ -257,77 +1597,340 @@ namespace ariel
     }
 
     // Scalar multiplication
-    Graph Graph::operator*(int scalar) const
+    Graph &Graph::operator*=(int scalar)
     {
-        Graph result = *this;
-        for (auto &row : result.adjacencyMatrix)
+        if (representation == Representation::Sparse && scalar == 0)
+        {
+            AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(numVertices) + 1);
+            AlignedBuffer<unsigned int> columns;
+            AlignedBuffer<int> values;
+            setSparse(numVertices, offsets, columns, values);
+        }
+        else if (representation == Representation::Bitset)
         {
-            for (auto &val : row)
+            bitWeight *= scalar;
+            if (bitWeight == 0)
             {
-                val *= scalar;
+                std::fill(adjacencyBits.begin(), adjacencyBits.end(), 0);
             }
         }
-        return result;
-    }
-
-    Graph &Graph::operator*=(int scalar)
-    {
-        for (auto &row : adjacencyMatrix)
+        else
         {
-            for (auto &val : row)
+            Kernels::multiplyScalar(weights.data(), scalar, weights.size());
+            Kernels::multiplyScalar(edgeWeights.data(), scalar, edgeWeights.size());
+            // An odd scalar is invertible modulo 2^32, so only even ones can wrap an entry to zero
+            if (representation == Representation::Sparse && scalar % 2 == 0)
             {
-                val *= scalar;
+                dropZeroEntries();
             }
         }
+
+        // Scaling keeps symmetry, and maps the extremes to the extremes unless a product overflows
+        long long scaledMin = static_cast<long long>(summary.minWeight) * scalar;
+        long long scaledMax = static_cast<long long>(summary.maxWeight) * scalar;
+        if (scalar == 0)
+        {
+            summary = Summary{true, 0, 0, 0};
+            symmetry = Symmetry::Symmetric;
+        }
+        else if (std::min(scaledMin, scaledMax) < std::numeric_limits<int>::min() ||
+                 std::max(scaledMin, scaledMax) > std::numeric_limits<int>::max())
+        {
+            summary.known = false;
+        }
+        else if (summary.known)
+        {
+            summary.minWeight = static_cast<int>(std::min(scaledMin, scaledMax));
+            summary.maxWeight = static_cast<int>(std::max(scaledMin, scaledMax));
+        }
         return *this;
     }
 
     // Graph multiplication
     Graph Graph::operator*(const Graph &other) const
+    {
+        return product<PlusTimes>(other);
+    }
+
+    template <typename Semiring>
+    Graph Graph::product(const Graph &other) const
     {
         if (getNumVertices() != other.getNumVertices())
         {
             throw std::invalid_argument("The number of columns in the first matrix must be equal to the number of rows in the second matrix.");
         }
-        using size_type = typename std::vector<int>::size_type;
+        if (std::is_same<Semiring, PlusTimes>::value && representation == Representation::Sparse &&
+            other.representation == Representation::Sparse)
+        {
+            return sparseProduct(other);
+        }
+        Graph scratchA;
+        Graph scratchB;
+        const Graph &lhs = denseView(scratchA);
+        const Graph &rhs = other.denseView(scratchB);
+        std::size_t width = lhs.stride;
+        AlignedBuffer<int> valuesA;
+        AlignedBuffer<int> valuesB;
+        const int *a = semiringValues<Semiring>(lhs.weights.data(), numVertices, width, valuesA);
+        const int *b = semiringValues<Semiring>(rhs.weights.data(), numVertices, width, valuesB);
+
+        Graph result;
+        result.resize(numVertices);
+        int *c = result.weights.data();
+        clearValues<Semiring>(c, numVertices, width);
+        ProductScratch scratch;
+        multiplySquare<Semiring>(a, b, c, numVertices, width, scratch);
+        storeEntries<Semiring>(c, numVertices, width);
+        return result;
+    }
+
+    // Gustavson's row-by-row product of two sparse graphs. Rows are split into tasks of about the same
+    // number of multiplications; each task has its own accumulators and collects its rows before
+    // they are copied into the result.
+    Graph Graph::sparseProduct(const Graph &other) const
+    {
+        unsigned int n = numVertices;
+        CsrView a = {rowOffsets.data(), columnIndices.data(), edgeWeights.data()};
+        CsrView b = {other.rowOffsets.data(), other.columnIndices.data(), other.edgeWeights.data()};
+        std::vector<std::size_t> work(n);
+        std::size_t totalWork = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            for (std::size_t p = a.offsets[i]; p < a.offsets[i + 1]; ++p)
+            {
+                work[i] += b.offsets[a.columns[p] + 1] - b.offsets[a.columns[p]];
+            }
+            totalWork += work[i];
+        }
+
+        std::size_t taskCount = std::min<std::size_t>(n, static_cast<std::size_t>(ThreadPool::instance().size()) * SPARSE_TASKS_PER_THREAD);
+        std::vector<unsigned int> bounds(1, 0);
+        std::size_t done = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            done += work[i];
+            if (done * taskCount >= totalWork * bounds.size() && bounds.size() < taskCount)
+            {
+                bounds.push_back(i + 1);
+            }
+        }
+        bounds.push_back(n);
+
+        std::vector<SparseRows> rows(bounds.size() - 1);
+        AlignedBuffer<std::size_t> offsets(static_cast<std::size_t>(n) + 1);
+        std::size_t *rowCounts = offsets.data() + 1;
+        ThreadPool::instance().parallelFor(rows.size(), [&](std::size_t t)
+        {
+            multiplySparseRows(a, b, n, bounds[t], bounds[t + 1], work.data(), rowCounts, rows[t]);
+        });
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            offsets[i + 1] += offsets[i];
+        }
+
+        AlignedBuffer<unsigned int> columns(offsets[n]);
+        AlignedBuffer<int> values(offsets[n]);
+        ThreadPool::instance().parallelFor(rows.size(), [&](std::size_t t)
+        {
+            std::size_t first = offsets[bounds[t]];
+            std::copy(rows[t].columns.begin(), rows[t].columns.end(), columns.data() + first);
+            std::copy(rows[t].values.begin(), rows[t].values.end(), values.data() + first);
+        });
+
+        Graph result;
+        result.setSparse(n, offsets, columns, values);
+        return result;
+    }
+
+    template Graph Graph::product<PlusTimes>(const Graph &other) const;
+    template Graph Graph::product<MinPlus>(const Graph &other) const;
+
+    void Graph::setStrassenCutoff(unsigned int vertices)
+    {
+        strassenCutoff = vertices;
+    }
+
+    unsigned int Graph::getStrassenCutoff()
+    {
+        return strassenCutoff;
+    }
+
+    Graph Graph::pow(unsigned int k, Overflow overflow) const
+    {
+        Graph scratch;
+        const Graph &base = denseView(scratch);
+        unsigned int n = numVertices;
+        std::size_t width = strideFor(n);
         Graph result;
-        result.loadGraph(std::vector<std::vector<int>>(static_cast<size_type>(getNumVertices()), std::vector<int>(static_cast<size_type>(getNumVertices()), 0)));
+        result.resize(n);
+        if (k == 0)
+        {
+            for (unsigned int u = 0; u < n; ++u)
+            {
+                result.weights[u * width + u] = 1;
+            }
+            return result;
+        }
 
-        for (size_type i = 0; i < static_cast<size_type>(getNumVertices()); ++i)
+        // power holds base^(2^i); the result starts as the first power selected by a bit of k
+        AlignedBuffer<int> power(base.weights);
+        AlignedBuffer<int> product(n * width);
+        ProductScratch buffers;
+        AlignedBuffer<long long> wide(overflow == Overflow::Throw ? n * width : 0);
+        AlignedBuffer<__int128> exact; // only for entries large enough to overflow 64-bit sums
+        bool started = false;
+        while (true)
         {
-            for (size_type j = 0; j < static_cast<size_type>(getNumVertices()); ++j)
+            if (k & 1)
             {
-                for (size_type k = 0; k < static_cast<size_type>(getNumVertices()); ++k)
+                if (!started)
                 {
-                    result.adjacencyMatrix[i][j] += adjacencyMatrix[i][k] * other.adjacencyMatrix[k][j];
+                    std::memcpy(result.weights.data(), power.data(), n * width * sizeof(int));
+                    started = true;
                 }
+                else
+                {
+                    powerStep(result.weights.data(), power.data(), product.data(), n, width, buffers, wide, exact, overflow);
+                    result.weights.swap(product);
+                }
+            }
+            k >>= 1;
+            if (k == 0)
+            {
+                break;
             }
+            powerStep(power.data(), power.data(), product.data(), n, width, buffers, wide, exact, overflow);
+            power.swap(product);
+        }
+        return result;
+    }
+
+    // Boolean product on bit rows: row i of the result is the OR of the rows k of other
+    // that row i of this graph selects, so every word carries 64 columns
+    template <>
+    Graph Graph::product<OrAnd>(const Graph &other) const
+    {
+        if (getNumVertices() != other.getNumVertices())
+        {
+            throw std::invalid_argument("The number of columns in the first matrix must be equal to the number of rows in the second matrix.");
         }
+        unsigned int n = numVertices;
+        std::size_t words = (static_cast<std::size_t>(n) + 63) / 64;
+        AlignedBuffer<std::uint64_t> a(words * n);
+        AlignedBuffer<std::uint64_t> b(words * n);
+        AlignedBuffer<std::uint64_t> c(words * n);
+        packBits(a.data());
+        other.packBits(b.data());
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            // Every vertex reaches itself (OrAnd::fromEntry)
+            a[u * words + u / 64] |= std::uint64_t(1) << (u % 64);
+            b[u * words + u / 64] |= std::uint64_t(1) << (u % 64);
+        }
+
+        const std::uint64_t *aBits = a.data();
+        const std::uint64_t *bBits = b.data();
+        std::uint64_t *cBits = c.data();
+        unsigned int rowBlocks = (n + ROW_BLOCK - 1) / ROW_BLOCK;
+        ThreadPool::instance().parallelFor(rowBlocks, [=](std::size_t block)
+        {
+            unsigned int iBegin = static_cast<unsigned int>(block) * ROW_BLOCK;
+            unsigned int iEnd = std::min(n, iBegin + ROW_BLOCK);
+            for (unsigned int i = iBegin; i < iEnd; ++i)
+            {
+                const std::uint64_t *ai = aBits + i * words;
+                std::uint64_t *ci = cBits + i * words;
+                for (std::size_t w = 0; w < words; ++w)
+                {
+                    for (std::uint64_t word = ai[w]; word != 0; word &= word - 1)
+                    {
+                        std::size_t k = w * 64 + static_cast<std::size_t>(__builtin_ctzll(word));
+                        orRow(ci, bBits + k * words, words);
+                    }
+                }
+                ci[i / 64] &= ~(std::uint64_t(1) << (i % 64)); // OrAnd::toEntry keeps the diagonal empty
+            }
+        });
+
+        Graph result;
+        result.setBits(n, c, 1);
         return result;
     }
 
     // Output operator
+    // Slot of the output mode in the iword array of every stream; 0 is dense, the default
+    static int outputModeIndex()
+    {
+        static const int index = std::ios_base::xalloc();
+        return index;
+    }
+
+    std::ostream &dense(std::ostream &os)
+    {
+        os.iword(outputModeIndex()) = 0;
+        return os;
+    }
+
+    std::ostream &sparse(std::ostream &os)
+    {
+        os.iword(outputModeIndex()) = 1;
+        return os;
+    }
+
+    // Both formats are built in the buffer of a TextWriter and reach the stream in large blocks
     std::ostream &operator<<(std::ostream &os, const Graph &graph)
     {
-        os << "[";
-        for (unsigned int i = 0; i < graph.adjacencyMatrix.size(); ++i)
+        unsigned int num = graph.getNumVertices();
+        TextWriter writer(os);
+        if (os.iword(outputModeIndex()) != 0)
+        {
+            bool first = true;
+            for (unsigned int i = 0; i < num; ++i)
+            {
+                for (Neighbor next : graph.neighbors(i))
+                {
+                    writer.write(first ? "(" : " (", first ? 1 : 2);
+                    first = false;
+                    writer.writeUnsigned(i);
+                    writer.put(',');
+                    writer.writeUnsigned(next.vertex);
+                    writer.put(',');
+                    writer.writeInt(next.weight);
+                    writer.put(')');
+                }
+            }
+            return os;
+        }
+
+        std::vector<int> sparseRow(graph.representation != Representation::Dense ? num : 0);
+        writer.put('[');
+        for (unsigned int i = 0; i < num; ++i)
         {
-            os << "[";
-            for (unsigned int j = 0; j < graph.adjacencyMatrix[i].size(); ++j)
+            const int *r = sparseRow.data();
+            if (graph.representation == Representation::Dense)
+            {
+                r = graph.getRow(i);
+            }
+            else
+            {
+                graph.copyRow(i, sparseRow.data());
+            }
+            writer.put('[');
+            for (unsigned int j = 0; j < num; ++j)
             {
-                os << graph.adjacencyMatrix[i][j];
-                if (j < graph.adjacencyMatrix[i].size() - 1)
+                writer.writeInt(r[j]);
+                if (j < num - 1)
                 {
-                    os << ", ";
+                    writer.write(", ", 2);
                 }
             }
-            os << "]";
-            if (i < graph.adjacencyMatrix.size() - 1)
+            writer.put(']');
+            if (i < num - 1)
             {
-                os << ", ";
+                writer.write(", ", 2);
             }
         }
-        os << "]";
+        writer.put(']');
         return os;
     }
-} // namespace ariel
\ No newline at end of file
+} // namespace ariel
@@ -1,18 +1,221 @@
 #ifndef GRAPH_HPP
 #define GRAPH_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
+#include "AlignedBuffer.hpp"
+#include "Kernels.hpp"
+#include "Semiring.hpp"
 
 namespace ariel {
+    // Storage layout of a Graph
+    enum class Representation {
+        Dense,  // row-major V x V matrix
+        Sparse, // compressed sparse rows: row offsets, column indices, weights
+        Bitset  // one bit per entry, 64 vertices per word; all edges share one weight
+    };
+
+    // What Graph::loadGraph checks
+    enum class Validation {
+        Checked, // square matrix with a zero diagonal, std::invalid_argument otherwise
+        Trusted  // nothing; the caller guarantees both (a short row is undefined behavior)
+    };
+
+    // What Graph::pow does with entries that do not fit in an int
+    enum class Overflow {
+        Wrap,  // int sums that wrap around, like operator*
+        Throw  // exact 64- or 128-bit sums; std::overflow_error if an entry does not fit back in an int
+    };
+
+    // A single matrix entry: the weight of the edge from -> to
+    struct Edge {
+        unsigned int from;
+        unsigned int to;
+        int weight;
+    };
+
+    // A neighbor of a vertex together with the weight of the edge leading to it
+    struct Neighbor {
+        unsigned int vertex;
+        int weight;
+    };
+
+    // Forward iterator over the non-zero entries of one row, read straight from the graph storage
+    class NeighborIterator {
+        public:
+            // Dense rows pass the row and leave columns null; sparse rows pass their column and weight arrays
+            NeighborIterator(const int *values, const unsigned int *columns, std::size_t index, std::size_t count)
+                : values(values), columns(columns), bits(nullptr), weight(0), index(index), count(count)
+            {
+                skipZeros();
+            }
+
+            // Bitset rows pass their words and the weight shared by all edges
+            NeighborIterator(const std::uint64_t *bits, int weight, std::size_t index, std::size_t count)
+                : values(nullptr), columns(nullptr), bits(bits), weight(weight), index(index), count(count)
+            {
+                skipZeros();
+            }
+
+            Neighbor operator*() const
+            {
+                if (columns != nullptr)
+                {
+                    return Neighbor{columns[index], values[index]};
+                }
+                return Neighbor{static_cast<unsigned int>(index), bits != nullptr ? weight : values[index]};
+            }
+
+            NeighborIterator &operator++()
+            {
+                ++index;
+                skipZeros();
+                return *this;
+            }
+
+            // Index of the current entry within the row storage, usable with NeighborRange::at
+            std::size_t position() const { return index; }
+
+            bool operator==(const NeighborIterator &other) const { return index == other.index; }
+            bool operator!=(const NeighborIterator &other) const { return index != other.index; }
+
+        private:
+            void skipZeros()
+            {
+                if (bits != nullptr)
+                {
+                    skipClearBits();
+                }
+                else if (columns == nullptr)
+                {
+                    while (index < count && values[index] == 0)
+                    {
+                        ++index;
+                    }
+                }
+            }
+
+            // Jump a whole word at a time to the next set bit; bits past count are always clear
+            void skipClearBits()
+            {
+                if (index >= count)
+                {
+                    return;
+                }
+                std::size_t word = index / 64;
+                std::uint64_t remaining = bits[word] & (~std::uint64_t(0) << (index % 64));
+                while (remaining == 0)
+                {
+                    if (++word * 64 >= count)
+                    {
+                        index = count;
+                        return;
+                    }
+                    remaining = bits[word];
+                }
+                index = word * 64 + static_cast<std::size_t>(__builtin_ctzll(remaining));
+            }
+
+            const int *values;
+            const unsigned int *columns;
+            const std::uint64_t *bits;
+            int weight;
+            std::size_t index;
+            std::size_t count;
+    };
+
+    // The neighbors of one vertex, usable in a range-based for loop; no allocation involved
+    class NeighborRange {
+        public:
+            NeighborRange(const int *values, const unsigned int *columns, std::size_t count)
+                : values(values), columns(columns), bits(nullptr), weight(0), count(count) {}
+
+            NeighborRange(const std::uint64_t *bits, int weight, std::size_t count)
+                : values(nullptr), columns(nullptr), bits(bits), weight(weight), count(count) {}
+
+            NeighborIterator begin() const { return at(0); }
+            NeighborIterator end() const { return at(count); }
+
+            // Resume iteration at a position previously returned by NeighborIterator::position
+            NeighborIterator at(std::size_t position) const
+            {
+                if (bits != nullptr)
+                {
+                    return NeighborIterator(bits, weight, position, count);
+                }
+                return NeighborIterator(values, columns, position, count);
+            }
+
+        private:
+            const int *values;
+            const unsigned int *columns;
+            const std::uint64_t *bits;
+            int weight;
+            std::size_t count;
+    };
+
+    // Base of the lazy elementwise expressions built by +, - and scalar * (see the end of this file).
+    // Nothing is computed until the expression is assigned to a Graph. The queries of Graph are
+    // available too, for code written when these operators returned graphs: all but
+    // getNumVertices() evaluate the expression first.
+    template <typename E>
+    class GraphExpression {
+        public:
+            const E &self() const { return static_cast<const E &>(*this); }
+
+            unsigned int getNumVertices() const { return self().size(); }
+            int getNumEdges() const;
+            bool containsEdge(unsigned int u, unsigned int v) const;
+            unsigned int *getNeighbors(unsigned int u, unsigned int &size) const;
+            int getWeight(unsigned int u, unsigned int v) const;
+            void printGraph() const;
+    };
+
+    class GraphOperand;
+
     class Graph {
         public:
             Graph();
             ~Graph();
 
-            // Load the graph from the adjacency matrix
-            void loadGraph(const std::vector<std::vector<int>> &adjacencyMatrix);
+            Graph(const Graph &other);
+            Graph &operator=(const Graph &other);
+
+            // Moves take over the storage and leave the source an empty graph
+            Graph(Graph &&other) noexcept;
+            Graph &operator=(Graph &&other) noexcept;
+
+            // Evaluate an expression such as g1 + g2 - g3 * 2 in a single pass, without intermediate graphs
+            template <typename E>
+            Graph(const GraphExpression<E> &expression);
+
+            template <typename E>
+            Graph &operator=(const GraphExpression<E> &expression);
+
+            // Load the graph from the adjacency matrix. Validation costs O(V); rows are counted
+            // and copied by the thread pool.
+            void loadGraph(const std::vector<std::vector<int>> &adjacencyMatrix, Validation validation = Validation::Checked);
+
+            // Same, but frees every row of the matrix as soon as it is copied, so the matrix and
+            // the graph are never both held in full; the matrix is left empty
+            void loadGraph(std::vector<std::vector<int>> &&adjacencyMatrix, Validation validation = Validation::Checked);
+
+            // Load the graph from a list of directed entries (zero weights are skipped, later duplicates win)
+            void loadEdges(unsigned int numVertices, const std::vector<Edge> &edges);
+
+            // Current storage layout; loadGraph and loadEdges pick it from the density
+            Representation getRepresentation() const;
+
+            // Convert the storage to the given layout.
+            // Bitset throws std::invalid_argument unless every edge has the same weight.
+            void setRepresentation(Representation representation);
 
             // Print the graph (for debugging purposes)
             void printGraph() const;
@@ -20,25 +223,59 @@ namespace ariel {
             // Get the number of vertices in the graph
             unsigned int getNumVertices() const;
 
-            // Get the number of edges in the graph
+            // Get the number of edges in the graph.
+            // This and the other summaries of the weights below are cached: the first query after a change
+            // scans the graph once, later ones are O(1). Like any lazily filled cache, concurrent first
+            // queries on one graph must be synchronized by the caller.
             int getNumEdges() const;
 
+            // Smallest and largest edge weight (0 when there are no edges)
+            int getMinWeight() const;
+            int getMaxWeight() const;
+
+            // Whether some edge has a negative weight
+            bool hasNegativeWeight() const;
+
             // Check if there is an edge from u to v
             bool containsEdge(unsigned int u, unsigned int v) const;
 
-            // return array of neighbors
+            // return array of neighbors (the caller must delete[] it; prefer neighbors())
             unsigned int *getNeighbors(unsigned int u, unsigned int &size) const;
 
+            // Iterate over the (vertex, weight) pairs of the outgoing edges of u in increasing vertex order
+            NeighborRange neighbors(unsigned int u) const;
+
             // return the weight between u and v
             int getWeight(unsigned int u, unsigned int v) const;
 
-            // Arithmetic operators
-            Graph operator+(const Graph &graph) const;
+            // Check if getWeight(u, v) == getWeight(v, u) for every pair (cached)
+            bool isSymmetric() const;
+
+            // The graph with every edge reversed, in the same representation
+            Graph transpose() const;
+
+            // Distance (in ints) between the starts of two consecutive rows (dense only)
+            std::size_t getRowStride() const;
+
+            // Pointer to the getNumVertices() weights of row u (dense only)
+            const int *getRow(unsigned int u) const;
+
+            // Distance (in words) between two consecutive bit rows, and the words of row u (bitset only).
+            // Bit v % 64 of word v / 64 is set when there is an edge u -> v; bits past the last vertex are zero.
+            std::size_t getBitRowStride() const;
+            const std::uint64_t *getBitRow(unsigned int u) const;
+
+            // The weight every edge of a bitset graph has
+            int getBitWeight() const;
+
+            // Arithmetic operators (binary +, - and unary - are expressions, declared below the class)
             Graph &operator+=(const Graph &graph);
-            Graph operator-(const Graph &graph) const;
             Graph &operator-=(const Graph &graph);
+            template <typename E>
+            Graph &operator+=(const GraphExpression<E> &expression);
+            template <typename E>
+            Graph &operator-=(const GraphExpression<E> &expression);
             Graph operator+() const; // Unary plus
-            Graph operator-() const; // Unary minus
 
             // Comparison operators
             bool operator==(const Graph &graph) const;
@@ -54,20 +291,599 @@ namespace ariel {
             Graph& operator--();   // Prefix decrement
             Graph operator--(int); // Postfix decrement
 
-            // Scalar multiplication
-            Graph operator*(int scalar) const;
+            // Scalar multiplication (graph * scalar is an expression, declared below the class)
             Graph &operator*=(int scalar);
 
             // Graph multiplication
             Graph operator*(const Graph &graph) const;
 
+            // Matrix product over one of the semirings of Semiring.hpp; product<PlusTimes> is operator*.
+            // product<OrAnd> ORs whole bit rows, 64 vertices per word, and returns a bitset graph.
+            template <typename Semiring>
+            Graph product(const Graph &graph) const;
+
+            // Ordinary products of graphs with more vertices than the cutoff use Strassen-Winograd down
+            // to blocks of at most cutoff vertices; 0 turns it off. Not thread safe, meant for tuning.
+            static void setStrassenCutoff(unsigned int vertices);
+            static unsigned int getStrassenCutoff();
+
+            // The k-th power of the adjacency matrix (entry (u, v) counts the walks of k edges from u to v)
+            // by repeated squaring: O(log k) products that reuse the same buffers. pow(0) is the identity.
+            Graph pow(unsigned int k, Overflow overflow = Overflow::Wrap) const;
+
             // Output operator
             friend std::ostream &operator<<(std::ostream &os, const Graph &graph);
         private:
-            std::vector<std::vector<int>> adjacencyMatrix;
+            friend class GraphOperand;
+            friend class GraphIO;
+
+            template <typename E>
+            void assign(const E &expression);
+
+            // What the cached queries return; mutators either update it or mark it unknown
+            struct Summary {
+                bool known;
+                std::size_t nonZeros;
+                int minWeight;
+                int maxWeight;
+            };
+
+            enum class Symmetry : unsigned char {
+                Unknown,
+                Symmetric,
+                Asymmetric
+            };
+
+            const Summary &summarize() const;
+            void invalidateMetadata();
+
+            void swap(Graph &other) noexcept;
+            void loadRows(const std::vector<std::vector<int>> &adjacencyMatrix, std::vector<std::vector<int>> *release, Validation validation);
+            void loadEdgeParts(unsigned int numVertices, const std::vector<std::pair<const Edge *, std::size_t>> &parts);
+
+            // Rows are padded to a whole number of cache lines; padding is always zero
+            static std::size_t strideFor(unsigned int numVertices);
+            static Representation chooseRepresentation(unsigned int numVertices, std::size_t nonZeros);
+            void resize(unsigned int numVertices);
+            void setDense(unsigned int numVertices, AlignedBuffer<int> &values);
+            void setSparse(unsigned int numVertices, AlignedBuffer<std::size_t> &offsets, AlignedBuffer<unsigned int> &columns, AlignedBuffer<int> &values);
+            int *row(unsigned int u);
+            std::size_t findEntry(unsigned int u, unsigned int v) const;
+            void copyRow(unsigned int u, int *out) const;
+            void setBits(unsigned int numVertices, AlignedBuffer<std::uint64_t> &bits, int weight);
+            void packBits(std::uint64_t *bits) const;
+            void toDense();
+            void toSparse();
+            void dropZeroEntries();
+            void toBitset();
+            const Graph &denseView(Graph &scratch) const;
+            Graph sparseProduct(const Graph &other) const;
+
+            unsigned int numVertices;
+            Representation representation;
+
+            // Dense storage
+            std::size_t stride;
+            AlignedBuffer<int> weights; // row-major, numVertices rows of stride ints
 
+            // Sparse storage; columns are sorted within each row
+            AlignedBuffer<std::size_t> rowOffsets; // numVertices + 1 entries
+            AlignedBuffer<unsigned int> columnIndices;
+            AlignedBuffer<int> edgeWeights;
+
+            // Bitset storage
+            std::size_t bitStride; // words per row
+            AlignedBuffer<std::uint64_t> adjacencyBits;
+            int bitWeight;
+
+            // Cached metadata, see summarize() and isSymmetric()
+            mutable Summary summary;
+            mutable Symmetry symmetry;
     };
 
+    inline NeighborRange Graph::neighbors(unsigned int u) const
+    {
+        if (representation == Representation::Dense)
+        {
+            return NeighborRange(weights.data() + u * stride, nullptr, numVertices);
+        }
+        if (representation == Representation::Bitset)
+        {
+            return NeighborRange(adjacencyBits.data() + u * bitStride, bitWeight, numVertices);
+        }
+        std::size_t first = rowOffsets[u];
+        return NeighborRange(edgeWeights.data() + first, columnIndices.data() + first, rowOffsets[u + 1] - first);
+    }
+
+    // Instantiated in Graph.cpp
+    extern template Graph Graph::product<PlusTimes>(const Graph &graph) const;
+    extern template Graph Graph::product<MinPlus>(const Graph &graph) const;
+    template <> Graph Graph::product<OrAnd>(const Graph &graph) const;
+
+    // Needed so that expressions find the operator through their conversion to Graph
+    std::ostream &operator<<(std::ostream &os, const Graph &graph);
+
+    // Manipulators that choose how operator<< prints graphs on one stream, e.g. os << sparse << g.
+    // dense, the default, prints the whole matrix as [[0, 1], [1, 0]]; sparse prints only the
+    // non-zero entries as (u,v,w) triples separated by spaces.
+    std::ostream &dense(std::ostream &os);
+    std::ostream &sparse(std::ostream &os);
+
+    // Lazy elementwise expressions.
+    // Every node offers:
+    //   size()          number of vertices
+    //   prepare()       make the dense weights of every operand available (other layouts are expanded once)
+    //   at(i)           entry i of the row-major dense result, padding included (all operations keep zero at zero)
+    //   compactSource() the sparse or bitset graph the expression is a multiple of, or null
+    //   factor()        that multiple, when compactSource() is not null
+    // Operands are held by pointer, so an expression must be used within the statement that builds it.
+
+    // A graph used inside an expression
+    class GraphOperand : public GraphExpression<GraphOperand> {
+        public:
+            explicit GraphOperand(const Graph &graph) : graph(&graph), values(nullptr) {}
+
+            unsigned int size() const { return graph->numVertices; }
+
+            void prepare() const
+            {
+                if (graph->representation == Representation::Dense)
+                {
+                    values = graph->weights.data();
+                    return;
+                }
+                dense = std::make_shared<Graph>();
+                values = graph->denseView(*dense).weights.data();
+            }
+
+            int at(std::size_t i) const { return values[i]; }
+
+            // The dense weights, once prepared
+            const int *data() const { return values; }
+
+            const Graph *compactSource() const { return graph->representation != Representation::Dense ? graph : nullptr; }
+
+            int factor() const { return 1; }
+
+        private:
+            const Graph *graph;
+            mutable const int *values;
+            mutable std::shared_ptr<Graph> dense; // expanded copy of a sparse or bitset graph
+    };
+
+    // left + right, or left - right when Sign is -1
+    template <typename L, typename R, int Sign>
+    class GraphSum : public GraphExpression<GraphSum<L, R, Sign>> {
+        public:
+            GraphSum(const L &left, const R &right) : left(left), right(right)
+            {
+                if (left.size() != right.size())
+                {
+                    throw std::invalid_argument("Graphs must be of the same size.");
+                }
+            }
+
+            unsigned int size() const { return left.size(); }
+
+            void prepare() const
+            {
+                left.prepare();
+                right.prepare();
+            }
+
+            int at(std::size_t i) const { return Sign > 0 ? left.at(i) + right.at(i) : left.at(i) - right.at(i); }
+
+            const Graph *compactSource() const { return nullptr; }
+
+            int factor() const { return 1; }
+
+            const L &lhs() const { return left; }
+            const R &rhs() const { return right; }
+
+        private:
+            L left;
+            R right;
+    };
+
+    // operand * scalar; unary minus is a scaling by -1
+    template <typename E>
+    class GraphScaled : public GraphExpression<GraphScaled<E>> {
+        public:
+            GraphScaled(const E &operand, int scalar) : operand(operand), scalar(scalar) {}
+
+            unsigned int size() const { return operand.size(); }
+
+            void prepare() const { operand.prepare(); }
+
+            int at(std::size_t i) const { return operand.at(i) * scalar; }
+
+            const Graph *compactSource() const { return operand.compactSource(); }
+
+            int factor() const { return operand.factor() * scalar; }
+
+            const E &inner() const { return operand; }
+            int multiplier() const { return scalar; }
+
+        private:
+            E operand;
+            int scalar;
+    };
+
+    template <typename L, typename R>
+    GraphSum<L, R, 1> operator+(const GraphExpression<L> &left, const GraphExpression<R> &right)
+    {
+        return GraphSum<L, R, 1>(left.self(), right.self());
+    }
+
+    template <typename R>
+    GraphSum<GraphOperand, R, 1> operator+(const Graph &left, const GraphExpression<R> &right)
+    {
+        return GraphSum<GraphOperand, R, 1>(GraphOperand(left), right.self());
+    }
+
+    template <typename L>
+    GraphSum<L, GraphOperand, 1> operator+(const GraphExpression<L> &left, const Graph &right)
+    {
+        return GraphSum<L, GraphOperand, 1>(left.self(), GraphOperand(right));
+    }
+
+    inline GraphSum<GraphOperand, GraphOperand, 1> operator+(const Graph &left, const Graph &right)
+    {
+        return GraphSum<GraphOperand, GraphOperand, 1>(GraphOperand(left), GraphOperand(right));
+    }
+
+    template <typename L, typename R>
+    GraphSum<L, R, -1> operator-(const GraphExpression<L> &left, const GraphExpression<R> &right)
+    {
+        return GraphSum<L, R, -1>(left.self(), right.self());
+    }
+
+    template <typename R>
+    GraphSum<GraphOperand, R, -1> operator-(const Graph &left, const GraphExpression<R> &right)
+    {
+        return GraphSum<GraphOperand, R, -1>(GraphOperand(left), right.self());
+    }
+
+    template <typename L>
+    GraphSum<L, GraphOperand, -1> operator-(const GraphExpression<L> &left, const Graph &right)
+    {
+        return GraphSum<L, GraphOperand, -1>(left.self(), GraphOperand(right));
+    }
+
+    inline GraphSum<GraphOperand, GraphOperand, -1> operator-(const Graph &left, const Graph &right)
+    {
+        return GraphSum<GraphOperand, GraphOperand, -1>(GraphOperand(left), GraphOperand(right));
+    }
+
+    template <typename E>
+    GraphScaled<E> operator-(const GraphExpression<E> &operand)
+    {
+        return GraphScaled<E>(operand.self(), -1);
+    }
+
+    inline GraphScaled<GraphOperand> operator-(const Graph &operand)
+    {
+        return GraphScaled<GraphOperand>(GraphOperand(operand), -1);
+    }
+
+    template <typename E>
+    GraphScaled<E> operator*(const GraphExpression<E> &operand, int scalar)
+    {
+        return GraphScaled<E>(operand.self(), scalar);
+    }
+
+    inline GraphScaled<GraphOperand> operator*(const Graph &operand, int scalar)
+    {
+        return GraphScaled<GraphOperand>(GraphOperand(operand), scalar);
+    }
+
+    template <typename E>
+    GraphScaled<E> operator+(const GraphExpression<E> &operand)
+    {
+        return GraphScaled<E>(operand.self(), 1);
+    }
+
+    // Graph products and comparisons evaluate expression operands into graphs first, so that
+    // (a + b) * c or a * 2 == b read as they did when + and * returned graphs
+    template <typename T>
+    struct IsGraphExpression : std::is_base_of<GraphExpression<T>, T> {};
+
+    // Enabled when both operands are graphs or expressions, and at least one is an expression
+    template <typename L, typename R, typename Result>
+    struct MixedGraphOperands
+        : std::enable_if<(IsGraphExpression<L>::value || IsGraphExpression<R>::value) &&
+                             (IsGraphExpression<L>::value || std::is_same<L, Graph>::value) &&
+                             (IsGraphExpression<R>::value || std::is_same<R, Graph>::value),
+                         Result> {};
+
+    inline const Graph &evaluated(const Graph &graph)
+    {
+        return graph;
+    }
+
+    template <typename E>
+    Graph evaluated(const GraphExpression<E> &expression)
+    {
+        return Graph(expression.self());
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, Graph>::type operator*(const L &left, const R &right)
+    {
+        return evaluated(left) * evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator==(const L &left, const R &right)
+    {
+        return evaluated(left) == evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator!=(const L &left, const R &right)
+    {
+        return evaluated(left) != evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator<(const L &left, const R &right)
+    {
+        return evaluated(left) < evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator<=(const L &left, const R &right)
+    {
+        return evaluated(left) <= evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator>(const L &left, const R &right)
+    {
+        return evaluated(left) > evaluated(right);
+    }
+
+    template <typename L, typename R>
+    typename MixedGraphOperands<L, R, bool>::type operator>=(const L &left, const R &right)
+    {
+        return evaluated(left) >= evaluated(right);
+    }
+
+    template <typename E>
+    int GraphExpression<E>::getNumEdges() const
+    {
+        return evaluated(*this).getNumEdges();
+    }
+
+    template <typename E>
+    bool GraphExpression<E>::containsEdge(unsigned int u, unsigned int v) const
+    {
+        return evaluated(*this).containsEdge(u, v);
+    }
+
+    template <typename E>
+    unsigned int *GraphExpression<E>::getNeighbors(unsigned int u, unsigned int &size) const
+    {
+        return evaluated(*this).getNeighbors(u, size);
+    }
+
+    template <typename E>
+    int GraphExpression<E>::getWeight(unsigned int u, unsigned int v) const
+    {
+        return evaluated(*this).getWeight(u, v);
+    }
+
+    template <typename E>
+    void GraphExpression<E>::printGraph() const
+    {
+        evaluated(*this).printGraph();
+    }
+
+    // A temporary left operand is updated in place and moved into the result, so chains such as
+    // a * b + c - d reuse the buffer of the product instead of allocating another graph
+    inline Graph operator+(Graph &&left, const Graph &right)
+    {
+        left += right;
+        return std::move(left);
+    }
+
+    template <typename R>
+    Graph operator+(Graph &&left, const GraphExpression<R> &right)
+    {
+        left += right;
+        return std::move(left);
+    }
+
+    inline Graph operator-(Graph &&left, const Graph &right)
+    {
+        left -= right;
+        return std::move(left);
+    }
+
+    template <typename R>
+    Graph operator-(Graph &&left, const GraphExpression<R> &right)
+    {
+        left -= right;
+        return std::move(left);
+    }
+
+    inline Graph operator-(Graph &&operand)
+    {
+        operand *= -1;
+        return std::move(operand);
+    }
+
+    inline Graph operator*(Graph &&operand, int scalar)
+    {
+        operand *= scalar;
+        return std::move(operand);
+    }
+
+    // The expressions that map onto the dispatched kernels of Kernels.hpp: a sum, difference or
+    // multiple of prepared graphs. The generic overloads return false and leave the work to the
+    // per-entry loops of assign, += and -=. dst may be the weights of an operand.
+    template <typename E>
+    bool assignWithKernels(const E &, int *, std::size_t)
+    {
+        return false;
+    }
+
+    template <int Sign>
+    bool assignWithKernels(const GraphSum<GraphOperand, GraphOperand, Sign> &expression, int *dst, std::size_t n)
+    {
+        const int *left = expression.lhs().data();
+        const int *right = expression.rhs().data();
+        if (dst == right && dst != left)
+        {
+            // right - left would need a reversed subtraction, so negate first: -right + left
+            if (Sign < 0)
+            {
+                Kernels::negate(dst, n);
+            }
+            Kernels::add(dst, left, n);
+            return true;
+        }
+        if (dst != left)
+        {
+            std::memcpy(dst, left, n * sizeof(int));
+        }
+        if (Sign > 0)
+        {
+            Kernels::add(dst, right, n);
+        }
+        else
+        {
+            Kernels::subtract(dst, right, n);
+        }
+        return true;
+    }
+
+    inline bool assignWithKernels(const GraphScaled<GraphOperand> &expression, int *dst, std::size_t n)
+    {
+        const int *src = expression.inner().data();
+        if (dst != src)
+        {
+            std::memcpy(dst, src, n * sizeof(int));
+        }
+        if (expression.multiplier() == -1)
+        {
+            Kernels::negate(dst, n);
+        }
+        else
+        {
+            Kernels::multiplyScalar(dst, expression.multiplier(), n);
+        }
+        return true;
+    }
+
+    // dst += Sign * expression
+    template <int Sign, typename E>
+    bool accumulateWithKernels(const E &, int *, std::size_t)
+    {
+        return false;
+    }
+
+    template <int Sign>
+    bool accumulateWithKernels(const GraphScaled<GraphOperand> &expression, int *dst, std::size_t n)
+    {
+        // Negated in unsigned arithmetic, which wraps like the kernel does
+        unsigned int scalar = static_cast<unsigned int>(expression.multiplier());
+        Kernels::multiplyAdd(dst, expression.inner().data(), static_cast<int>(Sign > 0 ? scalar : 0u - scalar), n);
+        return true;
+    }
+
+    template <typename E>
+    Graph::Graph(const GraphExpression<E> &expression) : Graph()
+    {
+        assign(expression.self());
+    }
+
+    template <typename E>
+    Graph &Graph::operator=(const GraphExpression<E> &expression)
+    {
+        assign(expression.self());
+        return *this;
+    }
+
+    // A multiple of one sparse or bitset graph keeps its edges and its layout; anything else is evaluated densely.
+    // Entry i of the result only reads entry i of the operands, so this graph may appear in the expression.
+    template <typename E>
+    void Graph::assign(const E &expression)
+    {
+        const Graph *source = expression.compactSource();
+        if (source != nullptr)
+        {
+            int scalar = expression.factor();
+            if (source != this)
+            {
+                *this = *source;
+            }
+            *this *= scalar;
+            return;
+        }
+        expression.prepare();
+        if (representation != Representation::Dense || numVertices != expression.size())
+        {
+            resize(expression.size());
+        }
+        invalidateMetadata();
+        int *dst = weights.data();
+        if (assignWithKernels(expression, dst, weights.size()))
+        {
+            return;
+        }
+        for (std::size_t i = 0; i < weights.size(); ++i)
+        {
+            dst[i] = expression.at(i);
+        }
+    }
+
+    template <typename E>
+    Graph &Graph::operator+=(const GraphExpression<E> &expression)
+    {
+        const E &e = expression.self();
+        if (numVertices != e.size())
+        {
+            throw std::invalid_argument("Graphs must be of the same size.");
+        }
+        e.prepare();
+        toDense();
+        invalidateMetadata();
+        int *dst = weights.data();
+        if (accumulateWithKernels<1>(e, dst, weights.size()))
+        {
+            return *this;
+        }
+        for (std::size_t i = 0; i < weights.size(); ++i)
+        {
+            dst[i] += e.at(i);
+        }
+        return *this;
+    }
+
+    template <typename E>
+    Graph &Graph::operator-=(const GraphExpression<E> &expression)
+    {
+        const E &e = expression.self();
+        if (numVertices != e.size())
+        {
+            throw std::invalid_argument("Graphs must be of the same size.");
+        }
+        e.prepare();
+        toDense();
+        invalidateMetadata();
+        int *dst = weights.data();
+        if (accumulateWithKernels<-1>(e, dst, weights.size()))
+        {
+            return *this;
+        }
+        for (std::size_t i = 0; i < weights.size(); ++i)
+        {
+            dst[i] -= e.at(i);
+        }
+        return *this;
+    }
+
 } // namespace ariel
 
 #endif // GRAPH_HPP
@@ -0,0 +1,1139 @@
+#include "GraphIO.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "TextWriter.hpp"
+#include "ThreadPool.hpp"
+
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Graph files are written in host byte order, which must be little-endian"
+#endif
+
+namespace ariel
+{
+    static_assert(sizeof(std::size_t) == 8, "Row offsets are stored as 64-bit words");
+
+    const unsigned int GraphIO::MAX_TEXT_VERTICES;
+
+    static const char MAGIC[8] = {'A', 'R', 'I', 'E', 'L', 'G', 'R', '\0'};
+    static const std::size_t SECTION_ALIGNMENT = 64;
+
+    // The first 64 bytes of a graph file
+    struct FileHeader
+    {
+        char magic[8];
+        std::uint16_t version;
+        std::uint8_t representation; // 0 dense, 1 sparse, 2 bitset
+        std::uint8_t weightBytes;    // always 4
+        std::int32_t bitWeight;
+        std::uint64_t vertices;
+        std::uint64_t nonZeros;      // non-zero entries
+        std::uint64_t sparseEntries; // length of the column and weight arrays of a sparse graph
+        std::int32_t minWeight;
+        std::int32_t maxWeight;
+        std::uint64_t payloadBytes;
+        std::uint64_t checksum; // of the header with this field zeroed, then the payload
+    };
+
+    static_assert(sizeof(FileHeader) == 64, "The header is one cache line");
+    static_assert(AlignedBuffer<int>::ALIGNMENT == SECTION_ALIGNMENT, "Sections of a mapped file are valid buffers");
+
+    // Byte sizes of the payload sections, each rounded up to SECTION_ALIGNMENT
+    struct FileLayout
+    {
+        std::size_t sections[3];
+        std::size_t payloadBytes;
+    };
+
+    static std::size_t alignSection(std::size_t bytes)
+    {
+        return (bytes + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+    }
+
+    // count * unit, rounded up to a section; false if that does not fit in a size_t
+    static bool sectionBytes(std::size_t count, std::size_t unit, std::size_t &bytes)
+    {
+        if (__builtin_mul_overflow(count, unit, &bytes) || bytes > SIZE_MAX - SECTION_ALIGNMENT)
+        {
+            return false;
+        }
+        bytes = alignSection(bytes);
+        return true;
+    }
+
+    // FNV-1a over 64-bit words in four interleaved lanes, so that the multiplications do not wait on
+    // each other. Sections are whole cache lines, so every section starts on lane 0.
+    class Checksum
+    {
+    public:
+        Checksum()
+        {
+            for (std::uint64_t &lane : lanes)
+            {
+                lane = OFFSET_BASIS;
+            }
+        }
+
+        // Hash the bytes followed by zeros up to the next section boundary
+        void addSection(const void *data, std::size_t bytes)
+        {
+            const unsigned char *p = static_cast<const unsigned char *>(data);
+            std::size_t lines = bytes / SECTION_ALIGNMENT;
+            for (std::size_t i = 0; i < lines; ++i, p += SECTION_ALIGNMENT)
+            {
+                std::uint64_t words[8];
+                std::memcpy(words, p, SECTION_ALIGNMENT);
+                addLine(words);
+            }
+            if (bytes % SECTION_ALIGNMENT != 0)
+            {
+                std::uint64_t words[8] = {};
+                std::memcpy(words, p, bytes % SECTION_ALIGNMENT);
+                addLine(words);
+            }
+        }
+
+        std::uint64_t value() const
+        {
+            std::uint64_t hash = lanes[0];
+            for (int i = 1; i < 4; ++i)
+            {
+                hash = (hash ^ lanes[i]) * PRIME;
+            }
+            return hash;
+        }
+
+    private:
+        static const std::uint64_t OFFSET_BASIS = 14695981039346656037ULL;
+        static const std::uint64_t PRIME = 1099511628211ULL;
+
+        void addLine(const std::uint64_t *words)
+        {
+            for (int i = 0; i < 8; ++i)
+            {
+                lanes[i % 4] = (lanes[i % 4] ^ words[i]) * PRIME;
+            }
+        }
+
+        std::uint64_t lanes[4];
+    };
+
+    static std::runtime_error systemError(const std::string &what, const std::string &path)
+    {
+        return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+    }
+
+    // write(2) until every byte is out
+    static void writeAll(int fd, const void *data, std::size_t bytes, const std::string &path)
+    {
+        const char *p = static_cast<const char *>(data);
+        while (bytes != 0)
+        {
+            ssize_t written = ::write(fd, p, bytes);
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                throw systemError("Cannot write", path);
+            }
+            p += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+    }
+
+    // Section sizes of a graph with the given header and dense row stride; false if they cannot fit in
+    // a payload of payloadBytes
+    static bool layoutOf(const FileHeader &header, std::size_t stride, std::size_t payloadBytes, FileLayout &layout)
+    {
+        std::size_t vertices = static_cast<std::size_t>(header.vertices);
+        std::size_t entries = static_cast<std::size_t>(header.sparseEntries);
+        layout = FileLayout{{0, 0, 0}, 0};
+        bool fits = true;
+        switch (header.representation)
+        {
+        case 0:
+            fits = sectionBytes(vertices, stride * sizeof(int), layout.sections[0]);
+            break;
+        case 1:
+            fits = sectionBytes(vertices + 1, sizeof(std::uint64_t), layout.sections[0]) &&
+                   sectionBytes(entries, sizeof(std::uint32_t), layout.sections[1]) &&
+                   sectionBytes(entries, sizeof(std::int32_t), layout.sections[2]);
+            break;
+        default:
+            fits = sectionBytes(vertices, (vertices + 63) / 64 * sizeof(std::uint64_t), layout.sections[0]);
+            break;
+        }
+        for (std::size_t bytes : layout.sections)
+        {
+            fits = fits && bytes <= payloadBytes - layout.payloadBytes;
+            layout.payloadBytes += fits ? bytes : 0;
+        }
+        return fits;
+    }
+
+    // O(V + E) check that the sparse arrays describe sorted rows with columns in range and off the diagonal
+    static bool validRows(const std::size_t *offsets, const unsigned int *columns, std::size_t vertices, std::size_t entries)
+    {
+        if (offsets[0] != 0 || offsets[vertices] != entries)
+        {
+            return false;
+        }
+        for (std::size_t u = 0; u < vertices; ++u)
+        {
+            if (offsets[u] > offsets[u + 1] || offsets[u + 1] > entries)
+            {
+                return false;
+            }
+            for (std::size_t i = offsets[u]; i < offsets[u + 1]; ++i)
+            {
+                if (columns[i] >= vertices || columns[i] == u || (i > offsets[u] && columns[i] <= columns[i - 1]))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Dense rows with a zero diagonal and zero padding after the last vertex
+    static bool validDense(const int *values, std::size_t vertices, std::size_t stride)
+    {
+        for (std::size_t u = 0; u < vertices; ++u)
+        {
+            const int *row = values + u * stride;
+            if (row[u] != 0)
+            {
+                return false;
+            }
+            for (std::size_t v = vertices; v < stride; ++v)
+            {
+                if (row[v] != 0)
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    // Bit rows with the diagonal bit clear and no bits at or past the last vertex
+    static bool validBits(const std::uint64_t *bits, std::size_t vertices)
+    {
+        std::size_t words = (vertices + 63) / 64;
+        std::uint64_t tail = vertices % 64 != 0 ? ~std::uint64_t(0) << (vertices % 64) : 0;
+        for (std::size_t u = 0; u < vertices; ++u)
+        {
+            const std::uint64_t *row = bits + u * words;
+            if ((row[u / 64] >> (u % 64) & 1) != 0 || (row[words - 1] & tail) != 0)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void GraphIO::save(const Graph &graph, const std::string &path)
+    {
+        const Graph::Summary &summary = graph.summarize();
+        FileHeader header;
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.representation = static_cast<std::uint8_t>(graph.representation);
+        header.weightBytes = sizeof(int);
+        header.bitWeight = graph.representation == Representation::Bitset ? graph.bitWeight : 0;
+        header.vertices = graph.numVertices;
+        header.nonZeros = summary.nonZeros;
+        header.sparseEntries = graph.columnIndices.size();
+        header.minWeight = summary.minWeight;
+        header.maxWeight = summary.maxWeight;
+        header.checksum = 0;
+
+        // The sections straight from the graph storage; padding is written as zeros
+        const void *data[3] = {nullptr, nullptr, nullptr};
+        std::size_t bytes[3] = {0, 0, 0};
+        if (graph.representation == Representation::Dense)
+        {
+            data[0] = graph.weights.data();
+            bytes[0] = graph.weights.size() * sizeof(int);
+        }
+        else if (graph.representation == Representation::Sparse)
+        {
+            data[0] = graph.rowOffsets.data();
+            bytes[0] = graph.rowOffsets.size() * sizeof(std::size_t);
+            data[1] = graph.columnIndices.data();
+            bytes[1] = graph.columnIndices.size() * sizeof(unsigned int);
+            data[2] = graph.edgeWeights.data();
+            bytes[2] = graph.edgeWeights.size() * sizeof(int);
+        }
+        else
+        {
+            data[0] = graph.adjacencyBits.data();
+            bytes[0] = graph.adjacencyBits.size() * sizeof(std::uint64_t);
+        }
+        header.payloadBytes = 0;
+        for (std::size_t section : bytes)
+        {
+            header.payloadBytes += alignSection(section);
+        }
+
+        Checksum checksum;
+        checksum.addSection(&header, sizeof(header));
+        for (int i = 0; i < 3; ++i)
+        {
+            checksum.addSection(data[i], bytes[i]);
+        }
+        header.checksum = checksum.value();
+
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+        {
+            throw systemError("Cannot create", path);
+        }
+        try
+        {
+            static const char zeros[SECTION_ALIGNMENT] = {};
+            writeAll(fd, &header, sizeof(header), path);
+            for (int i = 0; i < 3; ++i)
+            {
+                writeAll(fd, data[i], bytes[i], path);
+                writeAll(fd, zeros, alignSection(bytes[i]) - bytes[i], path);
+            }
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+        if (::close(fd) != 0)
+        {
+            throw systemError("Cannot write", path);
+        }
+    }
+
+    Graph GraphIO::open(const std::string &path, Validation validation)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw systemError("Cannot open", path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw systemError("Cannot read", path);
+        }
+        std::size_t fileBytes = static_cast<std::size_t>(info.st_size);
+        if (fileBytes < sizeof(FileHeader))
+        {
+            ::close(fd);
+            throw std::invalid_argument("Not a graph file: " + path);
+        }
+        // Private and writable: the graph may change its storage in place, the file never sees it
+        void *address = ::mmap(nullptr, fileBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        int mapError = errno;
+        ::close(fd);
+        if (address == MAP_FAILED)
+        {
+            errno = mapError;
+            throw systemError("Cannot map", path);
+        }
+        std::shared_ptr<void> mapping(address, [fileBytes](void *p)
+                                      { ::munmap(p, fileBytes); });
+        char *base = static_cast<char *>(address);
+
+        FileHeader header;
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        {
+            throw std::invalid_argument("Not a graph file: " + path);
+        }
+        if (header.version != VERSION || header.weightBytes != sizeof(int) || header.representation > 2)
+        {
+            throw std::invalid_argument("Unsupported graph file version or format: " + path);
+        }
+        FileLayout layout;
+        if (header.vertices > UINT_MAX ||
+            !layoutOf(header, Graph::strideFor(static_cast<unsigned int>(header.vertices)), fileBytes - sizeof(FileHeader), layout) ||
+            header.payloadBytes != layout.payloadBytes || fileBytes != sizeof(FileHeader) + layout.payloadBytes)
+        {
+            throw std::invalid_argument("Graph file size does not match its header: " + path);
+        }
+
+        unsigned int vertices = static_cast<unsigned int>(header.vertices);
+        std::size_t entries = static_cast<std::size_t>(header.sparseEntries);
+        char *sections[3];
+        sections[0] = base + sizeof(FileHeader);
+        sections[1] = sections[0] + layout.sections[0];
+        sections[2] = sections[1] + layout.sections[1];
+
+        if (validation == Validation::Checked)
+        {
+            FileHeader unsummed = header;
+            unsummed.checksum = 0;
+            Checksum checksum;
+            checksum.addSection(&unsummed, sizeof(unsummed));
+            checksum.addSection(sections[0], layout.payloadBytes);
+            if (checksum.value() != header.checksum)
+            {
+                throw std::invalid_argument("Graph file checksum mismatch: " + path);
+            }
+            bool valid = true;
+            switch (header.representation)
+            {
+            case 0:
+                valid = validDense(reinterpret_cast<const int *>(sections[0]), vertices, Graph::strideFor(vertices));
+                break;
+            case 1:
+                valid = validRows(reinterpret_cast<const std::size_t *>(sections[0]), reinterpret_cast<const unsigned int *>(sections[1]), vertices, entries);
+                break;
+            default:
+                valid = validBits(reinterpret_cast<const std::uint64_t *>(sections[0]), vertices);
+                break;
+            }
+            if (!valid)
+            {
+                throw std::invalid_argument("Invalid graph storage in graph file: " + path);
+            }
+        }
+
+        Graph graph;
+        if (header.representation == 0)
+        {
+            AlignedBuffer<int> values(reinterpret_cast<int *>(sections[0]), static_cast<std::size_t>(vertices) * Graph::strideFor(vertices), mapping);
+            graph.setDense(vertices, values);
+        }
+        else if (header.representation == 1)
+        {
+            AlignedBuffer<std::size_t> offsets(reinterpret_cast<std::size_t *>(sections[0]), static_cast<std::size_t>(vertices) + 1, mapping);
+            AlignedBuffer<unsigned int> columns(reinterpret_cast<unsigned int *>(sections[1]), entries, mapping);
+            AlignedBuffer<int> values(reinterpret_cast<int *>(sections[2]), entries, mapping);
+            graph.setSparse(vertices, offsets, columns, values);
+        }
+        else
+        {
+            AlignedBuffer<std::uint64_t> bits(reinterpret_cast<std::uint64_t *>(sections[0]), static_cast<std::size_t>(vertices) * ((static_cast<std::size_t>(vertices) + 63) / 64), mapping);
+            graph.setBits(vertices, bits, header.bitWeight);
+        }
+        Graph::Summary summary{true, static_cast<std::size_t>(header.nonZeros), header.minWeight, header.maxWeight};
+        if (validation == Validation::Checked)
+        {
+            // The payload has been read once already, so counting it again is cheap next to a wrong edge count
+            const Graph::Summary &counted = graph.summarize();
+            if (counted.nonZeros != summary.nonZeros || counted.minWeight != summary.minWeight || counted.maxWeight != summary.maxWeight)
+            {
+                throw std::invalid_argument("Graph file header does not match its edges: " + path);
+            }
+        }
+        graph.summary = summary;
+        return graph;
+    }
+
+    // Bytes read from the input at a time
+    static const std::size_t READ_CHUNK = 1 << 20;
+
+    static bool isBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char *skipBlanks(const char *p)
+    {
+        while (isBlank(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    // Decimal digits at p, no larger than limit; p is left on the first character after them
+    static bool scanUnsigned(const char *&p, std::uint64_t limit, std::uint64_t &value)
+    {
+        const char *first = p;
+        value = 0;
+        for (unsigned int digit = static_cast<unsigned int>(*p - '0'); digit < 10; digit = static_cast<unsigned int>(*++p - '0'))
+        {
+            value = value * 10 + digit;
+            if (value > limit)
+            {
+                return false;
+            }
+        }
+        return p != first;
+    }
+
+    static bool scanInt(const char *&p, int &value)
+    {
+        bool negative = *p == '-';
+        p += negative || *p == '+' ? 1 : 0;
+        std::uint64_t magnitude;
+        if (!scanUnsigned(p, negative ? std::uint64_t(INT_MAX) + 1 : std::uint64_t(INT_MAX), magnitude))
+        {
+            return false;
+        }
+        value = static_cast<int>(negative ? -static_cast<std::int64_t>(magnitude) : static_cast<std::int64_t>(magnitude));
+        return true;
+    }
+
+    // Turns "u v w" lines into edges. Every chunk it is given ends with '\n', which stops the digit
+    // and blank loops, so the scanner never checks for the end of the chunk inside a line.
+    class EdgeListParser
+    {
+    public:
+        EdgeListParser() : vertices(0), lines(0), failure(nullptr) {}
+
+        void parse(const char *p, const char *end)
+        {
+            while (p != end)
+            {
+                ++lines;
+                p = skipBlanks(p);
+                if (*p == '#' || *p == '%')
+                {
+                    p = static_cast<const char *>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+                }
+                else if (*p != '\n')
+                {
+                    p = parseEdge(p);
+                }
+                ++p;
+            }
+        }
+
+        std::vector<Edge> edges;
+        unsigned int vertices; // largest endpoint + 1
+        std::size_t lines;     // lines seen so far, a malformed one included
+        const char *failure;   // what was wrong with the last line, once parse has thrown
+
+    private:
+        const char *parseEdge(const char *p)
+        {
+            std::uint64_t from, to;
+            int weight = 0;
+            bool valid = scanUnsigned(p, UINT64_MAX / 100, from) && isBlank(*p) &&
+                         scanUnsigned(p = skipBlanks(p), UINT64_MAX / 100, to) && isBlank(*p) &&
+                         scanInt(p = skipBlanks(p), weight) && *(p = skipBlanks(p)) == '\n';
+            if (!valid)
+            {
+                fail("Malformed edge");
+            }
+            if (std::max(from, to) >= GraphIO::MAX_TEXT_VERTICES)
+            {
+                fail("Vertex number too large");
+            }
+            // Zero weights are skipped by loadEdges, so only a weighted self-loop is an error
+            if (from == to && weight != 0)
+            {
+                fail("Self-loop");
+            }
+            edges.push_back(Edge{static_cast<unsigned int>(from), static_cast<unsigned int>(to), weight});
+            vertices = std::max(vertices, static_cast<unsigned int>(std::max(from, to)) + 1);
+            return p;
+        }
+
+        void fail(const char *what)
+        {
+            failure = what;
+            throw std::invalid_argument(std::string(what) + " on line " + std::to_string(lines));
+        }
+    };
+
+    // Whether the word at p (compared without case) ends at a blank or the end of the line; p moves past it
+    static bool scanWord(const char *&p, const char *word)
+    {
+        const char *q = p;
+        for (; *word != '\0'; ++word, ++q)
+        {
+            if (std::tolower(static_cast<unsigned char>(*q)) != *word)
+            {
+                return false;
+            }
+        }
+        if (!isBlank(*q) && *q != '\n')
+        {
+            return false;
+        }
+        p = skipBlanks(q);
+        return true;
+    }
+
+    // 1-based vertex number no larger than vertices, made 0-based
+    static bool scanVertex(const char *&p, unsigned int vertices, unsigned int &vertex)
+    {
+        std::uint64_t value;
+        if (!scanUnsigned(p, vertices, value) || value == 0)
+        {
+            return false;
+        }
+        vertex = static_cast<unsigned int>(value - 1);
+        return true;
+    }
+
+    static const char *endOfLine(const char *p)
+    {
+        while (*p != '\n')
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    // Matrix Market coordinate files: a banner, % comments, a "rows columns entries" line, then one
+    // "i j [value]" line per entry with 1-based indices. Symmetric files list one triangle, which is
+    // mirrored; pattern files have no values and give every edge weight 1.
+    class MatrixMarketParser
+    {
+    public:
+        MatrixMarketParser() : vertices(0), lines(0), sizeSeen(false), pattern(false), mirror(0), declared(0), entries(0) {}
+
+        void parse(const char *p, const char *end)
+        {
+            while (p != end)
+            {
+                ++lines;
+                if (lines == 1)
+                {
+                    p = parseBanner(p);
+                }
+                else if (*(p = skipBlanks(p)) == '%' || *p == '\n')
+                {
+                    p = endOfLine(p);
+                }
+                else
+                {
+                    p = sizeSeen ? parseEntry(p) : parseSize(p);
+                }
+                ++p;
+            }
+        }
+
+        // Check that the input held the entries its size line announced
+        void finish() const
+        {
+            if (!sizeSeen)
+            {
+                throw std::invalid_argument("Matrix Market size line missing");
+            }
+            if (entries != declared)
+            {
+                throw std::invalid_argument("Matrix Market entry count does not match the size line");
+            }
+        }
+
+        std::vector<Edge> edges;
+        unsigned int vertices;
+
+    private:
+        const char *parseBanner(const char *p)
+        {
+            if (std::strncmp(p, "%%MatrixMarket", 14) != 0 || !isBlank(p[14]))
+            {
+                fail("Not a Matrix Market file");
+            }
+            p = skipBlanks(p + 14);
+            if (!scanWord(p, "matrix") || !scanWord(p, "coordinate"))
+            {
+                fail("Only Matrix Market coordinate matrices are supported");
+            }
+            pattern = scanWord(p, "pattern");
+            if (!pattern && !scanWord(p, "integer"))
+            {
+                fail("Only integer and pattern Matrix Market matrices are supported");
+            }
+            mirror = scanWord(p, "general") ? 0 : scanWord(p, "symmetric") ? 1 : scanWord(p, "skew-symmetric") ? -1 : 2;
+            if (mirror == 2 || *p != '\n')
+            {
+                fail("Only general, symmetric and skew-symmetric Matrix Market matrices are supported");
+            }
+            return p;
+        }
+
+        const char *parseSize(const char *p)
+        {
+            std::uint64_t rows, columns;
+            bool valid = scanUnsigned(p, UINT_MAX, rows) && isBlank(*p) &&
+                         scanUnsigned(p = skipBlanks(p), UINT_MAX, columns) && isBlank(*p) &&
+                         scanUnsigned(p = skipBlanks(p), UINT64_MAX / 100, declared) && *(p = skipBlanks(p)) == '\n';
+            if (!valid)
+            {
+                fail("Malformed Matrix Market size line");
+            }
+            if (rows != columns)
+            {
+                fail("Matrix Market matrix is not square");
+            }
+            if (rows > GraphIO::MAX_TEXT_VERTICES)
+            {
+                fail("Matrix Market matrix too large");
+            }
+            vertices = static_cast<unsigned int>(rows);
+            sizeSeen = true;
+            edges.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(declared, READ_CHUNK)) * (mirror != 0 ? 2 : 1));
+            return p;
+        }
+
+        const char *parseEntry(const char *p)
+        {
+            unsigned int from, to;
+            int weight = 1;
+            bool valid = scanVertex(p, vertices, from) && isBlank(*p) &&
+                         scanVertex(p = skipBlanks(p), vertices, to) && (pattern || (isBlank(*p) && scanInt(p = skipBlanks(p), weight))) &&
+                         *(p = skipBlanks(p)) == '\n' && !(mirror < 0 && weight == INT_MIN);
+            if (!valid)
+            {
+                fail("Malformed Matrix Market entry");
+            }
+            if (++entries > declared)
+            {
+                fail("More Matrix Market entries than the size line declares");
+            }
+            // Explicit zeros on the diagonal are harmless and skipped with the other zeros
+            if (from == to && weight != 0)
+            {
+                fail("Non-zero Matrix Market diagonal entry");
+            }
+            edges.push_back(Edge{from, to, weight});
+            if (mirror != 0 && from != to)
+            {
+                edges.push_back(Edge{to, from, mirror * weight});
+            }
+            return p;
+        }
+
+        void fail(const char *what) const
+        {
+            throw std::invalid_argument(std::string(what) + " on line " + std::to_string(lines));
+        }
+
+        std::size_t lines;
+        bool sizeSeen;
+        bool pattern;
+        int mirror; // 0 general, 1 symmetric, -1 skew-symmetric
+        std::uint64_t declared;
+        std::uint64_t entries;
+    };
+
+    // DIMACS shortest-path files: c comments, one "p sp vertices arcs" line, then "a u v w" arcs with
+    // 1-based vertices
+    class DimacsParser
+    {
+    public:
+        DimacsParser() : vertices(0), lines(0), problemSeen(false), declared(0) {}
+
+        void parse(const char *p, const char *end)
+        {
+            while (p != end)
+            {
+                ++lines;
+                p = skipBlanks(p);
+                if (*p == 'c' || *p == '\n')
+                {
+                    p = endOfLine(p);
+                }
+                else if (*p == 'p' && !problemSeen && isBlank(p[1]))
+                {
+                    p = parseProblem(skipBlanks(p + 1));
+                }
+                else if (*p == 'a' && problemSeen && isBlank(p[1]))
+                {
+                    p = parseArc(skipBlanks(p + 1));
+                }
+                else
+                {
+                    fail("Malformed DIMACS line");
+                }
+                ++p;
+            }
+        }
+
+        // Check that the input held the arcs its problem line announced
+        void finish() const
+        {
+            if (!problemSeen)
+            {
+                throw std::invalid_argument("DIMACS problem line missing");
+            }
+            if (edges.size() != declared)
+            {
+                throw std::invalid_argument("DIMACS arc count does not match the problem line");
+            }
+        }
+
+        std::vector<Edge> edges;
+        unsigned int vertices;
+
+    private:
+        const char *parseProblem(const char *p)
+        {
+            std::uint64_t count;
+            bool valid = scanWord(p, "sp") && scanUnsigned(p, UINT_MAX, count) && isBlank(*p) &&
+                         scanUnsigned(p = skipBlanks(p), UINT64_MAX / 100, declared) && *(p = skipBlanks(p)) == '\n';
+            if (!valid)
+            {
+                fail("Malformed DIMACS problem line");
+            }
+            if (count > GraphIO::MAX_TEXT_VERTICES)
+            {
+                fail("DIMACS graph too large");
+            }
+            vertices = static_cast<unsigned int>(count);
+            problemSeen = true;
+            edges.reserve(static_cast<std::size_t>(std::min<std::uint64_t>(declared, READ_CHUNK)));
+            return p;
+        }
+
+        const char *parseArc(const char *p)
+        {
+            unsigned int from, to;
+            int weight;
+            bool valid = scanVertex(p, vertices, from) && isBlank(*p) &&
+                         scanVertex(p = skipBlanks(p), vertices, to) && isBlank(*p) &&
+                         scanInt(p = skipBlanks(p), weight) && *(p = skipBlanks(p)) == '\n';
+            if (!valid)
+            {
+                fail("Malformed DIMACS arc");
+            }
+            if (from == to && weight != 0)
+            {
+                fail("DIMACS self-loop");
+            }
+            edges.push_back(Edge{from, to, weight});
+            return p;
+        }
+
+        void fail(const char *what) const
+        {
+            throw std::invalid_argument(std::string(what) + " on line " + std::to_string(lines));
+        }
+
+        std::size_t lines;
+        bool problemSeen;
+        std::uint64_t declared;
+    };
+
+    // Parse what read(buffer, capacity) returns, 0 meaning the end of the input, chunk by chunk.
+    // Only whole lines are parsed; an unfinished one moves to the front of the buffer for the next read.
+    template <typename Read, typename Parser>
+    static void parseLines(Read read, Parser &parser)
+    {
+        std::vector<char> buffer(READ_CHUNK + 1); // one spare byte for a missing final newline
+        std::size_t held = 0;
+        while (true)
+        {
+            if (held == buffer.size() - 1)
+            {
+                buffer.resize(2 * buffer.size()); // a line longer than the buffer
+            }
+            char *data = buffer.data();
+            std::size_t got = read(data + held, buffer.size() - 1 - held);
+            if (got == 0)
+            {
+                if (held != 0)
+                {
+                    data[held] = '\n';
+                    parser.parse(data, data + held + 1);
+                }
+                break;
+            }
+            // Only the new bytes can hold a newline, the held ones had none
+            std::size_t filled = held + got;
+            std::size_t lineEnd = filled;
+            while (lineEnd > held && data[lineEnd - 1] != '\n')
+            {
+                --lineEnd;
+            }
+            if (lineEnd == held)
+            {
+                held = filled;
+                continue;
+            }
+            parser.parse(data, data + lineEnd);
+            held = filled - lineEnd;
+            std::memmove(data, data + lineEnd, held);
+        }
+    }
+
+    // read(2) with retries on interrupts
+    struct DescriptorRead
+    {
+        int fd;
+
+        std::size_t operator()(char *data, std::size_t capacity) const
+        {
+            while (true)
+            {
+                ssize_t got = ::read(fd, data, capacity);
+                if (got >= 0)
+                {
+                    return static_cast<std::size_t>(got);
+                }
+                if (errno != EINTR)
+                {
+                    throw systemError("Cannot read", "graph text");
+                }
+            }
+        }
+    };
+
+    struct StreamRead
+    {
+        std::istream *in;
+
+        std::size_t operator()(char *data, std::size_t capacity) const
+        {
+            in->read(data, static_cast<std::streamsize>(capacity));
+            if (in->bad())
+            {
+                throw std::runtime_error("Cannot read graph text");
+            }
+            return static_cast<std::size_t>(in->gcount());
+        }
+    };
+
+    template <typename Read>
+    static Graph readEdgeList(Read read, unsigned int minVertices)
+    {
+        EdgeListParser parser;
+        parseLines(read, parser);
+        Graph graph;
+        graph.loadEdges(std::max(minVertices, parser.vertices), parser.edges);
+        return graph;
+    }
+
+    Graph GraphIO::readEdges(std::istream &in, unsigned int minVertices)
+    {
+        return readEdgeList(StreamRead{&in}, minVertices);
+    }
+
+    Graph GraphIO::readEdges(int fd, unsigned int minVertices)
+    {
+        return readEdgeList(DescriptorRead{fd}, minVertices);
+    }
+
+    Graph GraphIO::readEdges(const std::string &path, unsigned int minVertices)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw systemError("Cannot open", path);
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0)
+        {
+            ::close(fd);
+            throw systemError("Cannot read", path);
+        }
+        std::size_t fileBytes = static_cast<std::size_t>(info.st_size);
+        std::shared_ptr<void> mapping;
+        const char *text = "";
+        if (fileBytes != 0)
+        {
+            void *address = ::mmap(nullptr, fileBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+            int mapError = errno;
+            if (address == MAP_FAILED)
+            {
+                ::close(fd);
+                errno = mapError;
+                throw systemError("Cannot map", path);
+            }
+            mapping.reset(address, [fileBytes](void *p)
+                          { ::munmap(p, fileBytes); });
+            text = static_cast<const char *>(address);
+        }
+        ::close(fd);
+
+        // One chunk per thread, each starting right after a newline. An unterminated last line is
+        // parsed from a copy with the newline the scanner needs.
+        std::size_t tailStart = fileBytes;
+        while (tailStart != 0 && text[tailStart - 1] != '\n')
+        {
+            --tailStart;
+        }
+        std::string tail(text + tailStart, fileBytes - tailStart);
+        tail += '\n';
+        std::size_t numChunks = ThreadPool::instance().size();
+        std::vector<std::size_t> bounds(numChunks + 1, tailStart);
+        bounds[0] = 0;
+        for (std::size_t c = 1; c < numChunks; ++c)
+        {
+            std::size_t pos = std::max(bounds[c - 1], tailStart / numChunks * c);
+            const void *newline = pos < tailStart ? std::memchr(text + pos, '\n', tailStart - pos) : nullptr;
+            bounds[c] = newline != nullptr ? static_cast<std::size_t>(static_cast<const char *>(newline) - text) + 1 : tailStart;
+        }
+
+        // Every chunk records its failure in its own parser, which no other thread touches
+        std::vector<EdgeListParser> parsers(numChunks);
+        ThreadPool::instance().parallelFor(numChunks, [&](std::size_t c)
+        {
+            try
+            {
+                parsers[c].parse(text + bounds[c], text + bounds[c + 1]);
+                if (c + 1 == numChunks && tail.size() > 1)
+                {
+                    parsers[c].parse(tail.data(), tail.data() + tail.size());
+                }
+            }
+            catch (const std::invalid_argument &)
+            {
+            }
+        });
+
+        // Chunks before the first failed one were parsed to the end, so their line counts add up
+        std::size_t line = 0;
+        unsigned int vertices = minVertices;
+        std::vector<std::pair<const Edge *, std::size_t>> parts;
+        for (std::size_t c = 0; c < numChunks; ++c)
+        {
+            line += parsers[c].lines;
+            if (parsers[c].failure != nullptr)
+            {
+                throw std::invalid_argument(std::string(parsers[c].failure) + " on line " + std::to_string(line));
+            }
+            vertices = std::max(vertices, parsers[c].vertices);
+            parts.push_back(std::make_pair(parsers[c].edges.data(), parsers[c].edges.size()));
+        }
+        Graph graph;
+        graph.loadEdgeParts(vertices, parts);
+        return graph;
+    }
+
+    // Parse a file with one of the parsers above and build the graph from its edges
+    template <typename Parser>
+    static Graph readFormat(const std::string &path, Parser &parser)
+    {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            throw systemError("Cannot open", path);
+        }
+        try
+        {
+            parseLines(DescriptorRead{fd}, parser);
+        }
+        catch (...)
+        {
+            ::close(fd);
+            throw;
+        }
+        ::close(fd);
+        parser.finish();
+        Graph graph;
+        graph.loadEdges(parser.vertices, parser.edges);
+        return graph;
+    }
+
+    template <typename Parser>
+    static Graph readFormat(std::istream &in, Parser &parser)
+    {
+        parseLines(StreamRead{&in}, parser);
+        parser.finish();
+        Graph graph;
+        graph.loadEdges(parser.vertices, parser.edges);
+        return graph;
+    }
+
+    // Write through a TextWriter into the file at path
+    template <typename Write>
+    static void writeFile(const std::string &path, Write write)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file)
+        {
+            throw systemError("Cannot create", path);
+        }
+        write(file);
+        file.close();
+        if (!file)
+        {
+            throw std::runtime_error("Cannot write " + path);
+        }
+    }
+
+    // "<prefix>u v w" for every edge, 1-based, straight from the graph storage
+    static void writeEntries(TextWriter &writer, const Graph &graph, const char *prefix)
+    {
+        std::size_t prefixLength = std::strlen(prefix);
+        for (unsigned int u = 0; u < graph.getNumVertices(); ++u)
+        {
+            for (Neighbor next : graph.neighbors(u))
+            {
+                writer.write(prefix, prefixLength);
+                writer.writeUnsigned(u + 1ULL);
+                writer.put(' ');
+                writer.writeUnsigned(next.vertex + 1ULL);
+                writer.put(' ');
+                writer.writeInt(next.weight);
+                writer.put('\n');
+            }
+        }
+    }
+
+    Graph GraphIO::readMatrixMarket(std::istream &in)
+    {
+        MatrixMarketParser parser;
+        return readFormat(in, parser);
+    }
+
+    Graph GraphIO::readMatrixMarket(const std::string &path)
+    {
+        MatrixMarketParser parser;
+        return readFormat(path, parser);
+    }
+
+    void GraphIO::writeMatrixMarket(const Graph &graph, std::ostream &out)
+    {
+        TextWriter writer(out);
+        writer.write("%%MatrixMarket matrix coordinate integer general\n");
+        writer.writeUnsigned(graph.numVertices);
+        writer.put(' ');
+        writer.writeUnsigned(graph.numVertices);
+        writer.put(' ');
+        writer.writeUnsigned(graph.summarize().nonZeros);
+        writer.put('\n');
+        writeEntries(writer, graph, "");
+    }
+
+    void GraphIO::writeMatrixMarket(const Graph &graph, const std::string &path)
+    {
+        writeFile(path, [&graph](std::ostream &out)
+                  { writeMatrixMarket(graph, out); });
+    }
+
+    Graph GraphIO::readDimacs(std::istream &in)
+    {
+        DimacsParser parser;
+        return readFormat(in, parser);
+    }
+
+    Graph GraphIO::readDimacs(const std::string &path)
+    {
+        DimacsParser parser;
+        return readFormat(path, parser);
+    }
+
+    void GraphIO::writeDimacs(const Graph &graph, std::ostream &out)
+    {
+        TextWriter writer(out);
+        writer.write("p sp ");
+        writer.writeUnsigned(graph.numVertices);
+        writer.put(' ');
+        writer.writeUnsigned(graph.summarize().nonZeros);
+        writer.put('\n');
+        writeEntries(writer, graph, "a ");
+    }
+
+    void GraphIO::writeDimacs(const Graph &graph, const std::string &path)
+    {
+        writeFile(path, [&graph](std::ostream &out)
+                  { writeDimacs(graph, out); });
+    }
+} // namespace ariel
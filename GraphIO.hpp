@@ -0,0 +1,76 @@
+#ifndef GRAPH_IO_HPP
+#define GRAPH_IO_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "Graph.hpp"
+
+namespace ariel {
+    // Graph files: a compact binary format that opens without parsing or copying, text edge lists,
+    // Matrix Market and DIMACS.
+    //
+    // A binary file is a 64-byte header followed by the storage of the graph exactly as it sits in memory,
+    // every section starting on a 64-byte boundary and padded with zeros:
+    //   Dense   V rows of getRowStride() ints
+    //   Sparse  V + 1 row offsets (uint64), then the column indices (uint32), then the weights (int32)
+    //   Bitset  V rows of getBitRowStride() words (uint64)
+    // All numbers are little-endian. The header holds the format version, the vertex and edge counts,
+    // the representation, the weight width, the weight range and a checksum of header and payload.
+    class GraphIO {
+        public:
+            static const unsigned int VERSION = 1;
+
+            // Most vertices a text file may declare or number, so that a stray large number is reported
+            // with its line instead of sizing the graph (sparse rows alone take 8 bytes per vertex)
+            static const unsigned int MAX_TEXT_VERTICES = 1u << 28;
+
+            // Write the graph in its current representation; std::runtime_error if the file cannot be written
+            static void save(const Graph &graph, const std::string &path);
+
+            // Map the file and return a graph whose storage points into the mapping; nothing is copied
+            // and pages are read on first touch. The mapping is private, so changing the graph never
+            // changes the file, and it is released with the last graph that uses it.
+            // Checked also verifies the checksum, the storage (a zero diagonal, zero padding and bits, sorted
+            // sparse rows) and the header's edge count and weight range, which reads the whole file;
+            // Trusted only checks the header against the file size.
+            // std::runtime_error if the file cannot be read, std::invalid_argument if it is not a valid graph file.
+            static Graph open(const std::string &path, Validation validation = Validation::Checked);
+
+            // Read a text edge list of "u v w" lines straight into a graph, with no matrix in between.
+            // Numbers are separated by blanks; empty lines and lines starting with # or % are skipped.
+            // Endpoints must be below MAX_TEXT_VERTICES.
+            // The graph has max(minVertices, largest endpoint + 1) vertices and is stored as loadEdges
+            // stores it. std::invalid_argument names the first malformed line or weighted self-loop;
+            // std::runtime_error if reading fails.
+            static Graph readEdges(std::istream &in, unsigned int minVertices = 0);
+
+            // Same, reading the file descriptor until end of file (it is not closed)
+            static Graph readEdges(int fd, unsigned int minVertices = 0);
+
+            // Same, for a whole file: it is mapped and cut at line boundaries into one chunk per thread,
+            // the chunks are parsed in parallel into their own edge lists, and a parallel counting sort
+            // by source merges them
+            static Graph readEdges(const std::string &path, unsigned int minVertices = 0);
+
+            // Matrix Market coordinate files (integer or pattern; general, symmetric or skew-symmetric).
+            // Symmetric files are mirrored, pattern entries get weight 1. The writers emit the non-zero
+            // entries of a general integer matrix, with a buffered integer formatter and no strings.
+            // std::invalid_argument names the first malformed line, non-zero diagonal entry or the unsupported
+            // header. Repeated coordinates keep the last non-zero value, as in Graph::loadEdges.
+            static Graph readMatrixMarket(std::istream &in);
+            static Graph readMatrixMarket(const std::string &path);
+            static void writeMatrixMarket(const Graph &graph, std::ostream &out);
+            static void writeMatrixMarket(const Graph &graph, const std::string &path);
+
+            // DIMACS shortest-path files: "p sp V E", then one "a u v w" line per edge (1-based). Self-loops
+            // with a non-zero weight are rejected with their line; repeated arcs keep the last one.
+            static Graph readDimacs(std::istream &in);
+            static Graph readDimacs(const std::string &path);
+            static void writeDimacs(const Graph &graph, std::ostream &out);
+            static void writeDimacs(const Graph &graph, const std::string &path);
+    };
+
+} // namespace ariel
+
+#endif // GRAPH_IO_HPP
@@ -0,0 +1,130 @@
+#ifndef INDEXED_HEAP_HPP
+#define INDEXED_HEAP_HPP
+
+#include <cstddef>
+#include <vector>
+
+namespace ariel {
+    // Min-heap of vertices keyed by Key, with O(log n) decrease-key.
+    // Each slot stores the key next to the vertex, so the Arity children compared in
+    // a sift-down sit in one or two cache lines instead of being looked up by vertex.
+    template <typename Key, unsigned int Arity = 4>
+    class IndexedHeap {
+        public:
+            // Vertices must be in [0, capacity)
+            explicit IndexedHeap(unsigned int capacity) : position(capacity, NOT_IN_HEAP)
+            {
+                slots.reserve(capacity);
+            }
+
+            bool empty() const { return slots.empty(); }
+            std::size_t size() const { return slots.size(); }
+            bool contains(unsigned int v) const { return position[v] != NOT_IN_HEAP; }
+
+            unsigned int top() const { return slots[0].vertex; }
+            Key topKey() const { return slots[0].key; }
+
+            // Insert v, or lower its key if it is already queued with a larger one
+            void pushOrDecrease(unsigned int v, Key key)
+            {
+                std::size_t i = position[v];
+                if (i == NOT_IN_HEAP)
+                {
+                    i = slots.size();
+                    slots.push_back(Slot{key, v});
+                }
+                else if (key < slots[i].key)
+                {
+                    slots[i].key = key;
+                }
+                else
+                {
+                    return;
+                }
+                siftUp(i);
+            }
+
+            // Remove and return the vertex with the smallest key
+            unsigned int pop()
+            {
+                unsigned int v = slots[0].vertex;
+                position[v] = NOT_IN_HEAP;
+                Slot last = slots.back();
+                slots.pop_back();
+                if (!slots.empty())
+                {
+                    slots[0] = last;
+                    position[last.vertex] = 0;
+                    siftDown(0);
+                }
+                return v;
+            }
+
+        private:
+            static const std::size_t NOT_IN_HEAP = static_cast<std::size_t>(-1);
+
+            struct Slot {
+                Key key;
+                unsigned int vertex;
+            };
+
+            void siftUp(std::size_t i)
+            {
+                Slot moving = slots[i];
+                while (i > 0)
+                {
+                    std::size_t parent = (i - 1) / Arity;
+                    if (!(moving.key < slots[parent].key))
+                    {
+                        break;
+                    }
+                    slots[i] = slots[parent];
+                    position[slots[i].vertex] = i;
+                    i = parent;
+                }
+                slots[i] = moving;
+                position[moving.vertex] = i;
+            }
+
+            void siftDown(std::size_t i)
+            {
+                Slot moving = slots[i];
+                std::size_t n = slots.size();
+                while (true)
+                {
+                    std::size_t first = i * Arity + 1;
+                    if (first >= n)
+                    {
+                        break;
+                    }
+                    std::size_t last = first + Arity < n ? first + Arity : n;
+                    std::size_t best = first;
+                    for (std::size_t c = first + 1; c < last; ++c)
+                    {
+                        if (slots[c].key < slots[best].key)
+                        {
+                            best = c;
+                        }
+                    }
+                    if (!(slots[best].key < moving.key))
+                    {
+                        break;
+                    }
+                    slots[i] = slots[best];
+                    position[slots[i].vertex] = i;
+                    i = best;
+                }
+                slots[i] = moving;
+                position[moving.vertex] = i;
+            }
+
+            std::vector<Slot> slots;
+            std::vector<std::size_t> position; // slot of each vertex, or NOT_IN_HEAP
+    };
+
+    template <typename Key, unsigned int Arity>
+    const std::size_t IndexedHeap<Key, Arity>::NOT_IN_HEAP;
+
+} // namespace ariel
+
+#endif // INDEXED_HEAP_HPP
@@ -0,0 +1,393 @@
+#include "Kernels.hpp"
+#include <limits>
+#include <stdexcept>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define ARIEL_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace ariel
+{
+    // One implementation of every kernel
+    struct KernelTable
+    {
+        void (*add)(int *dst, const int *src, std::size_t n);
+        void (*subtract)(int *dst, const int *src, std::size_t n);
+        void (*negate)(int *dst, std::size_t n);
+        void (*addScalar)(int *dst, int value, std::size_t n);
+        void (*multiplyScalar)(int *dst, int value, std::size_t n);
+        void (*multiplyAdd)(int *dst, const int *src, int value, std::size_t n);
+        void (*minPlus)(int *dst, const int *src, int value, std::size_t n);
+    };
+
+    static const int INFINITE = std::numeric_limits<int>::max();
+
+    // Portable versions, also used for the tails of the vector loops
+    static void addScalarLoop(int *dst, const int *src, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] += src[i];
+        }
+    }
+
+    static void subtractScalarLoop(int *dst, const int *src, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] -= src[i];
+        }
+    }
+
+    static void negateScalarLoop(int *dst, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] = -dst[i];
+        }
+    }
+
+    static void addValueScalarLoop(int *dst, int value, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] += value;
+        }
+    }
+
+    static void multiplyValueScalarLoop(int *dst, int value, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] *= value;
+        }
+    }
+
+    static void multiplyAddScalarLoop(int *dst, const int *src, int value, std::size_t n)
+    {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            dst[i] += value * src[i];
+        }
+    }
+
+    // Finite min-plus sums saturate to [INT_MIN, INT_MAX - 1], which keeps INT_MAX for infinity:
+    // src[i] is clamped to [lowest, highest] before value is added, so the sum cannot wrap
+    static int minPlusLowest(int value)
+    {
+        return value < 0 ? std::numeric_limits<int>::min() - value : std::numeric_limits<int>::min();
+    }
+
+    static int minPlusHighest(int value)
+    {
+        return value > 0 ? INFINITE - 1 - value : INFINITE - 1;
+    }
+
+    static void minPlusScalarLoop(int *dst, const int *src, int value, std::size_t n)
+    {
+        int lowest = minPlusLowest(value);
+        int highest = minPlusHighest(value);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            int clamped = src[i] < lowest ? lowest : (src[i] > highest ? highest : src[i]);
+            int candidate = src[i] == INFINITE ? INFINITE : clamped + value;
+            dst[i] = candidate < dst[i] ? candidate : dst[i];
+        }
+    }
+
+    static const KernelTable SCALAR_KERNELS = {
+        addScalarLoop, subtractScalarLoop, negateScalarLoop,
+        addValueScalarLoop, multiplyValueScalarLoop, multiplyAddScalarLoop, minPlusScalarLoop};
+
+#ifdef ARIEL_X86_KERNELS
+    // SSE4.1: 4 ints per instruction (pmulld needs 4.1)
+    __attribute__((target("sse4.1"))) static void addSse41(int *dst, const int *src, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi32(a, b));
+        }
+        addScalarLoop(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void subtractSse41(int *dst, const int *src, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_sub_epi32(a, b));
+        }
+        subtractScalarLoop(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void negateSse41(int *dst, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m128i zero = _mm_setzero_si128();
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_sub_epi32(zero, a));
+        }
+        negateScalarLoop(dst + i, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void addValueSse41(int *dst, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m128i v = _mm_set1_epi32(value);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi32(a, v));
+        }
+        addValueScalarLoop(dst + i, value, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void multiplyValueSse41(int *dst, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m128i v = _mm_set1_epi32(value);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_mullo_epi32(a, v));
+        }
+        multiplyValueScalarLoop(dst + i, value, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void multiplyAddSse41(int *dst, const int *src, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m128i v = _mm_set1_epi32(value);
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_add_epi32(a, _mm_mullo_epi32(b, v)));
+        }
+        multiplyAddScalarLoop(dst + i, src + i, value, n - i);
+    }
+
+    __attribute__((target("sse4.1"))) static void minPlusSse41(int *dst, const int *src, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m128i v = _mm_set1_epi32(value);
+        __m128i infinite = _mm_set1_epi32(INFINITE);
+        __m128i lowest = _mm_set1_epi32(minPlusLowest(value));
+        __m128i highest = _mm_set1_epi32(minPlusHighest(value));
+        for (; i + 4 <= n; i += 4)
+        {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+            __m128i sum = _mm_add_epi32(_mm_min_epi32(_mm_max_epi32(b, lowest), highest), v);
+            __m128i candidate = _mm_blendv_epi8(sum, infinite, _mm_cmpeq_epi32(b, infinite));
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_min_epi32(a, candidate));
+        }
+        minPlusScalarLoop(dst + i, src + i, value, n - i);
+    }
+
+    // AVX2: 8 ints per instruction
+    __attribute__((target("avx2"))) static void addAvx2(int *dst, const int *src, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_add_epi32(a, b));
+        }
+        addScalarLoop(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void subtractAvx2(int *dst, const int *src, std::size_t n)
+    {
+        std::size_t i = 0;
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_sub_epi32(a, b));
+        }
+        subtractScalarLoop(dst + i, src + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void negateAvx2(int *dst, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m256i zero = _mm256_setzero_si256();
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_sub_epi32(zero, a));
+        }
+        negateScalarLoop(dst + i, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void addValueAvx2(int *dst, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m256i v = _mm256_set1_epi32(value);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_add_epi32(a, v));
+        }
+        addValueScalarLoop(dst + i, value, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void multiplyValueAvx2(int *dst, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m256i v = _mm256_set1_epi32(value);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_mullo_epi32(a, v));
+        }
+        multiplyValueScalarLoop(dst + i, value, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void multiplyAddAvx2(int *dst, const int *src, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m256i v = _mm256_set1_epi32(value);
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_add_epi32(a, _mm256_mullo_epi32(b, v)));
+        }
+        multiplyAddScalarLoop(dst + i, src + i, value, n - i);
+    }
+
+    __attribute__((target("avx2"))) static void minPlusAvx2(int *dst, const int *src, int value, std::size_t n)
+    {
+        std::size_t i = 0;
+        __m256i v = _mm256_set1_epi32(value);
+        __m256i infinite = _mm256_set1_epi32(INFINITE);
+        __m256i lowest = _mm256_set1_epi32(minPlusLowest(value));
+        __m256i highest = _mm256_set1_epi32(minPlusHighest(value));
+        for (; i + 8 <= n; i += 8)
+        {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+            __m256i sum = _mm256_add_epi32(_mm256_min_epi32(_mm256_max_epi32(b, lowest), highest), v);
+            __m256i candidate = _mm256_blendv_epi8(sum, infinite, _mm256_cmpeq_epi32(b, infinite));
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_min_epi32(a, candidate));
+        }
+        minPlusScalarLoop(dst + i, src + i, value, n - i);
+    }
+
+    static const KernelTable SSE41_KERNELS = {
+        addSse41, subtractSse41, negateSse41,
+        addValueSse41, multiplyValueSse41, multiplyAddSse41, minPlusSse41};
+
+    static const KernelTable AVX2_KERNELS = {
+        addAvx2, subtractAvx2, negateAvx2,
+        addValueAvx2, multiplyValueAvx2, multiplyAddAvx2, minPlusAvx2};
+#endif
+
+    static const KernelTable &tableFor(InstructionSet set)
+    {
+#ifdef ARIEL_X86_KERNELS
+        if (set == InstructionSet::AVX2)
+        {
+            return AVX2_KERNELS;
+        }
+        if (set == InstructionSet::SSE41)
+        {
+            return SSE41_KERNELS;
+        }
+#endif
+        (void)set;
+        return SCALAR_KERNELS;
+    }
+
+    struct ActiveKernels
+    {
+        ActiveKernels() : set(Kernels::detect()), table(&tableFor(set)) {}
+
+        InstructionSet set;
+        const KernelTable *table;
+    };
+
+    // Picked on first use, so it is ready even for calls made during static initialization
+    static ActiveKernels &activeKernels()
+    {
+        static ActiveKernels active;
+        return active;
+    }
+
+    InstructionSet Kernels::detect()
+    {
+#ifdef ARIEL_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return InstructionSet::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.1"))
+        {
+            return InstructionSet::SSE41;
+        }
+#endif
+        return InstructionSet::Scalar;
+    }
+
+    InstructionSet Kernels::active()
+    {
+        return activeKernels().set;
+    }
+
+    void Kernels::select(InstructionSet set)
+    {
+        if (static_cast<int>(set) > static_cast<int>(detect()))
+        {
+            throw std::invalid_argument("Instruction set not supported by this CPU");
+        }
+        activeKernels().set = set;
+        activeKernels().table = &tableFor(set);
+    }
+
+    void Kernels::add(int *dst, const int *src, std::size_t n)
+    {
+        activeKernels().table->add(dst, src, n);
+    }
+
+    void Kernels::subtract(int *dst, const int *src, std::size_t n)
+    {
+        activeKernels().table->subtract(dst, src, n);
+    }
+
+    void Kernels::negate(int *dst, std::size_t n)
+    {
+        activeKernels().table->negate(dst, n);
+    }
+
+    void Kernels::addScalar(int *dst, int value, std::size_t n)
+    {
+        activeKernels().table->addScalar(dst, value, n);
+    }
+
+    void Kernels::multiplyScalar(int *dst, int value, std::size_t n)
+    {
+        activeKernels().table->multiplyScalar(dst, value, n);
+    }
+
+    void Kernels::multiplyAdd(int *dst, const int *src, int value, std::size_t n)
+    {
+        activeKernels().table->multiplyAdd(dst, src, value, n);
+    }
+
+    void Kernels::minPlus(int *dst, const int *src, int value, std::size_t n)
+    {
+        activeKernels().table->minPlus(dst, src, value, n);
+    }
+} // namespace ariel
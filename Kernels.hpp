@@ -0,0 +1,51 @@
+#ifndef KERNELS_HPP
+#define KERNELS_HPP
+
+#include <cstddef>
+
+namespace ariel {
+    // Instruction sets the elementwise kernels are compiled for
+    enum class InstructionSet {
+        Scalar,
+        SSE41,
+        AVX2
+    };
+
+    // Elementwise loops over contiguous int arrays. Each call goes through a table that is
+    // filled once with the widest implementation the running CPU supports.
+    class Kernels {
+    public:
+        // dst[i] += src[i]
+        static void add(int *dst, const int *src, std::size_t n);
+
+        // dst[i] -= src[i]
+        static void subtract(int *dst, const int *src, std::size_t n);
+
+        // dst[i] = -dst[i]
+        static void negate(int *dst, std::size_t n);
+
+        // dst[i] += value
+        static void addScalar(int *dst, int value, std::size_t n);
+
+        // dst[i] *= value
+        static void multiplyScalar(int *dst, int value, std::size_t n);
+
+        // dst[i] += value * src[i]
+        static void multiplyAdd(int *dst, const int *src, int value, std::size_t n);
+
+        // dst[i] = min(dst[i], value + src[i]), where src[i] == INT_MAX stands for infinity and is skipped.
+        // Finite sums saturate to [INT_MIN, INT_MAX - 1] instead of wrapping, so they never read as infinity.
+        static void minPlus(int *dst, const int *src, int value, std::size_t n);
+
+        // Best instruction set of this CPU, and the one the kernels currently use
+        static InstructionSet detect();
+        static InstructionSet active();
+
+        // Switch implementations (for tests and benchmarks; not thread safe).
+        // Throws std::invalid_argument if the CPU does not support the set.
+        static void select(InstructionSet set);
+    };
+
+} // namespace ariel
+
+#endif // KERNELS_HPP
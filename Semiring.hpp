@@ -0,0 +1,52 @@
+#ifndef SEMIRING_HPP
+#define SEMIRING_HPP
+
+#include <limits>
+
+namespace ariel {
+    // Semirings for Graph::product. Each one says how graph entries become semiring values
+    // (fromEntry), how the values combine (zero, add, multiply), and how the result is stored
+    // back in a graph (toEntry). In all three, a zero entry off the diagonal means "no edge".
+
+    // Ordinary integer product; product<PlusTimes> is operator*
+    struct PlusTimes {
+        static int zero() { return 0; }
+        static int add(int a, int b) { return a + b; }
+        static int multiply(int a, int b) { return a * b; }
+        static int fromEntry(int weight, bool /*diagonal*/) { return weight; }
+        static int toEntry(int value, bool /*diagonal*/) { return value; }
+    };
+
+    // Shortest distances: every vertex reaches itself at cost 0 and missing edges cost infinity,
+    // so the product holds the lightest walks of at most two edges. Unreachable pairs are stored
+    // as 0; a negative diagonal entry means a negative cycle through that vertex.
+    struct MinPlus {
+        static int zero() { return std::numeric_limits<int>::max(); }
+        static int add(int a, int b) { return a < b ? a : b; }
+        static int multiply(int a, int b)
+        {
+            // Finite sums saturate below infinity, as in Kernels::minPlus
+            if (a == zero() || b == zero())
+            {
+                return zero();
+            }
+            long long sum = static_cast<long long>(a) + b;
+            return sum >= zero() ? zero() - 1 : (sum < std::numeric_limits<int>::min() ? std::numeric_limits<int>::min() : static_cast<int>(sum));
+        }
+        static int fromEntry(int weight, bool diagonal) { return diagonal ? 0 : (weight == 0 ? zero() : weight); }
+        static int toEntry(int value, bool /*diagonal*/) { return value == zero() ? 0 : value; }
+    };
+
+    // Reachability: every vertex reaches itself, so the product marks the pairs joined by a walk of
+    // at most two edges with weight 1. The result is a bitset graph; diagonal entries stay 0.
+    struct OrAnd {
+        static int zero() { return 0; }
+        static int add(int a, int b) { return a | b; }
+        static int multiply(int a, int b) { return a & b; }
+        static int fromEntry(int weight, bool diagonal) { return diagonal || weight != 0 ? 1 : 0; }
+        static int toEntry(int value, bool diagonal) { return diagonal ? 0 : value; }
+    };
+
+} // namespace ariel
+
+#endif // SEMIRING_HPP
@@ -1,6 +1,25 @@
 #include "doctest.h"
 #include "Graph.hpp"
+#include "GraphIO.hpp"
+#include "Algorithms.hpp"
+#include "DepthFirstSearch.hpp"
+#include "Kernels.hpp"
+#include "TextWriter.hpp"
+#include "ThreadPool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <map>
+#include <random>
 #include <sstream>
+#include <type_traits>
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace ariel;
 
@@ -180,3 +199,1763 @@ TEST_CASE("Test Output Operator")
     os << g;
     CHECK(os.str() == "[[0, 1], [1, 0]]");
 }
+
+TEST_CASE("Test Contiguous Row Storage")
+{
+    Graph g;
+    std::vector<std::vector<int>> graph = {
+        {0, 1, 2},
+        {3, 0, 4},
+        {5, 6, 0}};
+    g.loadGraph(graph);
+
+    CHECK(g.getRowStride() >= g.getNumVertices());
+    CHECK(g.getRow(1) == g.getRow(0) + g.getRowStride());
+    CHECK(reinterpret_cast<std::uintptr_t>(g.getRow(0)) % 64 == 0);
+    CHECK(g.getRow(2)[1] == 6);
+
+    // Every operator keeps the row padding zero, so equality stays exact
+    Graph g1 = (g + g) - g;
+    CHECK(g1 == g);
+    CHECK_THROWS(g.loadGraph({{1}}));
+}
+
+TEST_CASE("Test Sparse Representation")
+{
+    // A 100-vertex ring is far below the density threshold
+    const unsigned int n = 100;
+    std::vector<Edge> edges;
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        edges.push_back(Edge{u, (u + 1) % n, 1});
+        edges.push_back(Edge{(u + 1) % n, u, 1});
+    }
+    Graph sparse;
+    sparse.loadEdges(n, edges);
+    CHECK(sparse.getRepresentation() == Representation::Sparse);
+    CHECK(sparse.getNumEdges() == 100);
+    CHECK(sparse.containsEdge(99, 0));
+    CHECK_FALSE(sparse.containsEdge(0, 2));
+    CHECK_THROWS(sparse.getRow(0));
+
+    Graph dense = sparse;
+    dense.setRepresentation(Representation::Dense);
+    CHECK(dense == sparse);
+    CHECK(Algorithms::isConnected(sparse) == 1);
+    CHECK(Algorithms::shortestPath(sparse, 0, 3) == "0->1->2->3");
+    CHECK(Algorithms::isBipartite(sparse) == Algorithms::isBipartite(dense));
+
+    // Later duplicates win and zero weights are dropped
+    Graph small;
+    small.loadEdges(3, {Edge{0, 1, 5}, Edge{0, 1, 7}, Edge{1, 2, 0}});
+    CHECK(small.getWeight(0, 1) == 7);
+    CHECK_FALSE(small.containsEdge(1, 2));
+    CHECK_THROWS(small.loadEdges(3, {Edge{0, 3, 1}}));
+
+    // Operators that add edges produce dense results
+    Graph doubled = sparse + sparse;
+    CHECK(doubled.getRepresentation() == Representation::Dense);
+    CHECK(doubled.getWeight(0, 1) == 2);
+    CHECK(Graph(-sparse).getRepresentation() == Representation::Sparse);
+}
+
+TEST_CASE("Test Neighbor Iteration")
+{
+    Graph g;
+    std::vector<std::vector<int>> graph = {
+        {0, 4, 0, 7},
+        {4, 0, 0, 0},
+        {0, 0, 0, 0},
+        {7, 0, -2, 0}};
+    g.loadGraph(graph);
+
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        std::vector<unsigned int> vertices;
+        std::vector<int> weights;
+        for (Neighbor next : g.neighbors(3))
+        {
+            vertices.push_back(next.vertex);
+            weights.push_back(next.weight);
+        }
+        CHECK(vertices == std::vector<unsigned int>({0, 2}));
+        CHECK(weights == std::vector<int>({7, -2}));
+        CHECK(g.neighbors(2).begin() == g.neighbors(2).end());
+
+        unsigned int size;
+        unsigned int *legacy = g.getNeighbors(0, size);
+        CHECK(size == 2);
+        CHECK(legacy[1] == 3);
+        delete[] legacy;
+
+        g.setRepresentation(Representation::Sparse);
+    }
+}
+
+TEST_CASE("Test Connectivity Engine")
+{
+    // Directed cycle 0->1->2->0 is strongly connected, the path 0->1->2 is not
+    Graph cycle, path;
+    cycle.loadGraph({{0, 1, 0}, {0, 0, 1}, {1, 0, 0}});
+    path.loadGraph({{0, 1, 0}, {0, 0, 1}, {0, 0, 0}});
+    CHECK_FALSE(cycle.isSymmetric());
+    CHECK(cycle.transpose().getWeight(0, 2) == 1);
+    CHECK(Algorithms::isConnected(cycle) == 1);
+    CHECK(Algorithms::isConnected(path) == 0);
+
+    std::vector<AlgorithmStats> reports;
+    Algorithms::setStatsHook([&reports](const AlgorithmStats &stats) { reports.push_back(stats); });
+
+    // A long undirected path would overflow the stack of a recursive traversal
+    const unsigned int n = 1000000;
+    std::vector<Edge> edges;
+    for (unsigned int u = 0; u + 1 < n; ++u)
+    {
+        edges.push_back(Edge{u, u + 1, 1});
+        edges.push_back(Edge{u + 1, u, 1});
+    }
+    Graph longPath;
+    longPath.loadEdges(n, edges);
+    CHECK(longPath.isSymmetric());
+    CHECK(Algorithms::isConnected(longPath) == 1);
+    Algorithms::setStatsHook(nullptr);
+
+    REQUIRE(reports.size() == 1);
+    CHECK(reports[0].traversals == 1);
+    CHECK(reports[0].verticesVisited == n);
+    CHECK(reports[0].edgesScanned == edges.size());
+}
+
+struct OrderRecorder : DfsVisitor
+{
+    bool preVisit(unsigned int u)
+    {
+        order.push_back(static_cast<int>(u));
+        return true;
+    }
+
+    void postVisit(unsigned int u)
+    {
+        order.push_back(-static_cast<int>(u) - 1);
+    }
+
+    std::vector<int> order;
+};
+
+TEST_CASE("Test Iterative Depth First Search")
+{
+    // 0 - 1 - 3 and 0 - 2: the recursive order is pre 0, 1, 3, post 3, 1, pre 2, post 2, 0
+    Graph g;
+    g.loadGraph({{0, 1, 1, 0},
+                 {1, 0, 0, 1},
+                 {1, 0, 0, 0},
+                 {0, 1, 0, 0}});
+    DepthFirstSearch dfs(g);
+    OrderRecorder recorder;
+    CHECK(dfs.run(0, recorder));
+    CHECK(recorder.order == std::vector<int>({0, 1, 3, -4, -2, 2, -3, -1}));
+    CHECK(dfs.getParent(3) == 1);
+    CHECK(dfs.getParent(0) == DepthFirstSearch::NO_PARENT);
+    CHECK(Algorithms::isContainsCycle(g) == 0);
+
+    // Closing 2 - 3 creates the cycle 0 - 1 - 3 - 2 - 0, in both representations
+    g.loadGraph({{0, 1, 1, 0},
+                 {1, 0, 0, 1},
+                 {1, 0, 0, 1},
+                 {0, 1, 1, 0}});
+    CHECK(Algorithms::isContainsCycle(g) == 1);
+    g.setRepresentation(Representation::Sparse);
+    CHECK(Algorithms::isContainsCycle(g) == 1);
+}
+
+TEST_CASE("Test Weighted Shortest Paths")
+{
+    // The direct edge 0->3 is heavier than going around through 1 and 2
+    Graph g;
+    g.loadGraph({{0, 1, 0, 10},
+                 {1, 0, 2, 0},
+                 {0, 2, 0, 3},
+                 {10, 0, 3, 0}});
+    CHECK(Algorithms::shortestPath(g, 0, 3) == "0->1->2->3");
+    CHECK(Algorithms::shortestPath(g, 0, 3, PathOptions(PathMethod::Dijkstra)) == "0->1->2->3");
+    CHECK(Algorithms::shortestPath(g, 0, 3, PathOptions(PathMethod::BreadthFirst)) == "0->3");
+    CHECK(Algorithms::shortestPath(g, 2, 2) == "2");
+    g.setRepresentation(Representation::Sparse);
+    CHECK(Algorithms::shortestPath(g, 3, 0) == "3->2->1->0");
+
+    // Directed graph with a negative edge but no negative cycle
+    Graph directed;
+    directed.loadGraph({{0, 4, 1, 0},
+                        {0, 0, 0, 1},
+                        {0, -3, 0, 5},
+                        {0, 0, 0, 0}});
+    CHECK(Algorithms::shortestPath(directed, 0, 3) == "0->2->1->3");
+    CHECK(Algorithms::shortestPath(directed, 3, 0) == "-1");
+
+    // A negative undirected edge is a negative cycle, so no path is well defined
+    Graph negative;
+    negative.loadGraph({{0, -1, 0},
+                        {-1, 0, 1},
+                        {0, 1, 0}});
+    CHECK(Algorithms::shortestPath(negative, 0, 2) == "-1");
+}
+
+TEST_CASE("Test Bidirectional Breadth First Search")
+{
+    // Directed: 0->1->2->3 plus a shortcut 0->4->3
+    Graph directed;
+    directed.loadGraph({{0, 1, 0, 0, 1},
+                        {0, 0, 1, 0, 0},
+                        {0, 0, 0, 1, 0},
+                        {0, 0, 0, 0, 0},
+                        {0, 0, 0, 1, 0}});
+    PathOptions bidirectional(PathMethod::Bidirectional);
+    CHECK(Algorithms::shortestPath(directed, 0, 3, bidirectional) == "0->4->3");
+    CHECK(Algorithms::shortestPath(directed, 3, 0, bidirectional) == "-1");
+    Graph reversed = directed.transpose();
+    CHECK(Algorithms::shortestPath(directed, 1, 3, PathOptions(PathMethod::Bidirectional, &reversed)) == "1->2->3");
+
+    // On a random sparse graph both searches agree on the number of hops
+    const unsigned int n = 500;
+    std::mt19937 rng(7);
+    std::vector<Edge> edges;
+    for (unsigned int i = 0; i < 3 * n; ++i)
+    {
+        unsigned int u = rng() % n;
+        unsigned int v = rng() % n;
+        if (u != v)
+        {
+            edges.push_back(Edge{u, v, 1});
+        }
+    }
+    Graph random;
+    random.loadEdges(n, edges);
+    int mismatches = 0;
+    for (unsigned int q = 0; q < 50; ++q)
+    {
+        unsigned int s = rng() % n;
+        unsigned int t = rng() % n;
+        std::string a = Algorithms::shortestPath(random, s, t, PathOptions(PathMethod::BreadthFirst));
+        std::string b = Algorithms::shortestPath(random, s, t, bidirectional);
+        if (std::count(a.begin(), a.end(), '>') != std::count(b.begin(), b.end(), '>') || (a == "-1") != (b == "-1"))
+        {
+            mismatches++;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("Test Structured Path Results")
+{
+    Graph g;
+    g.loadGraph({{0, 1, 0, 10},
+                 {1, 0, 2, 0},
+                 {0, 2, 0, 3},
+                 {10, 0, 3, 0}});
+    PathResult result;
+    CHECK(Algorithms::findPath(g, 0, 3, result));
+    CHECK(result.vertices == std::vector<unsigned int>({0, 1, 2, 3}));
+    CHECK(result.distance == 6);
+    CHECK(Algorithms::formatPath(result) == "0->1->2->3");
+
+    // The same result object is reused for the next query
+    CHECK(Algorithms::findPath(g, 0, 3, result, PathOptions(PathMethod::BreadthFirst)));
+    CHECK(result.vertices == std::vector<unsigned int>({0, 3}));
+    CHECK(result.distance == 10);
+
+    Graph disconnected;
+    disconnected.loadGraph({{0, 0}, {0, 0}});
+    CHECK_FALSE(Algorithms::findPath(disconnected, 0, 1, result));
+    CHECK(result.vertices.empty());
+    CHECK(Algorithms::formatPath(result) == "-1");
+}
+
+TEST_CASE("Test Negative Cycle Detection")
+{
+    // 1 -> 2 -> 3 -> 1 weighs -1 and is not reachable from vertex 0
+    Graph g;
+    g.loadGraph({{0, 0, 0, 0},
+                 {0, 0, 2, 0},
+                 {0, 0, 0, -4},
+                 {5, 1, 0, 0}});
+    std::vector<unsigned int> cycle;
+    CHECK(Algorithms::negativeCycle(g, cycle));
+    CHECK(cycle == std::vector<unsigned int>({1, 2, 3}));
+    g.setRepresentation(Representation::Sparse);
+    CHECK(Algorithms::negativeCycle(g));
+
+    // Raising 3 -> 1 to 2 makes the cycle positive
+    Graph positive;
+    positive.loadGraph({{0, 0, 0, 0},
+                        {0, 0, 2, 0},
+                        {0, 0, 0, -4},
+                        {5, 2, 0, 0}});
+    CHECK_FALSE(Algorithms::negativeCycle(positive, cycle));
+    CHECK(cycle.empty());
+}
+
+TEST_CASE("Test Thread Pool")
+{
+    ThreadPool pool(4);
+    CHECK(pool.size() == 4);
+    std::vector<int> hits(1000, 0);
+    pool.parallelFor(hits.size(), [&hits](std::size_t i) { hits[i]++; });
+    CHECK(std::count(hits.begin(), hits.end(), 1) == 1000);
+
+    // Nested calls run inline instead of deadlocking
+    std::atomic<int> total(0);
+    pool.parallelFor(8, [&pool, &total](std::size_t)
+                     { pool.parallelFor(8, [&total](std::size_t) { total++; }); });
+    CHECK(total == 64);
+
+    CHECK_THROWS_AS(pool.parallelFor(10, [](std::size_t i)
+                                     { if (i == 7) throw std::runtime_error("task failed"); }),
+                    std::runtime_error);
+}
+
+TEST_CASE("Test Blocked Graph Multiplication")
+{
+    // 530 crosses the row, depth and column block boundaries of the kernel
+    const unsigned int n = 530;
+    std::mt19937 rng(11);
+    std::vector<std::vector<int>> a(n, std::vector<int>(n, 0)), b = a;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            if (i != j)
+            {
+                a[i][j] = static_cast<int>(rng() % 5) - 2;
+                b[i][j] = static_cast<int>(rng() % 5) - 2;
+            }
+        }
+    }
+    Graph ga, gb;
+    ga.loadGraph(a);
+    gb.loadGraph(b);
+    Graph product = ga * gb;
+
+    int mismatches = 0;
+    std::vector<int> expected(n);
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        std::fill(expected.begin(), expected.end(), 0);
+        for (unsigned int k = 0; k < n; ++k)
+        {
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                expected[j] += a[i][k] * b[k][j];
+            }
+        }
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            mismatches += product.getWeight(i, j) != expected[j];
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+TEST_CASE("Test Elementwise Kernels")
+{
+    // 37 leaves a tail after every vector width
+    const std::size_t n = 37;
+    std::vector<int> src(n), base(n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        src[i] = static_cast<int>(i * 7 % 11) - 5;
+        base[i] = static_cast<int>(i * 3 % 13) - 6;
+    }
+
+    const InstructionSet sets[] = {InstructionSet::Scalar, InstructionSet::SSE41, InstructionSet::AVX2};
+    for (InstructionSet set : sets)
+    {
+        if (static_cast<int>(set) > static_cast<int>(Kernels::detect()))
+        {
+            CHECK_THROWS(Kernels::select(set));
+            continue;
+        }
+        Kernels::select(set);
+        CHECK(Kernels::active() == set);
+
+        std::vector<int> v = base;
+        Kernels::add(v.data(), src.data(), n);
+        Kernels::subtract(v.data(), src.data(), n);
+        CHECK(v == base);
+
+        Kernels::multiplyAdd(v.data(), src.data(), 3, n);
+        Kernels::addScalar(v.data(), -2, n);
+        Kernels::multiplyScalar(v.data(), 5, n);
+        Kernels::negate(v.data(), n);
+        int mismatches = 0;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            mismatches += v[i] != -5 * (base[i] + 3 * src[i] - 2);
+        }
+        CHECK(mismatches == 0);
+
+        Graph g1, g2;
+        g1.loadGraph({{0, 1, 2}, {3, 0, 4}, {5, 6, 0}});
+        g2.loadGraph({{0, 2, 0}, {0, 0, 1}, {1, 0, 0}});
+        std::ostringstream sum, negated, incremented;
+        sum << g1 + g2;
+        negated << -(g1 * 2);
+        incremented << ++g2;
+        CHECK(sum.str() == "[[0, 3, 2], [3, 0, 5], [6, 6, 0]]");
+        CHECK(negated.str() == "[[0, -2, -4], [-6, 0, -8], [-10, -12, 0]]");
+        CHECK(incremented.str() == "[[1, 3, 1], [1, 1, 2], [2, 1, 1]]");
+    }
+    Kernels::select(Kernels::detect());
+}
+
+TEST_CASE("Test Graph Expressions")
+{
+    Graph g1, g2, g3;
+    g1.loadGraph({{0, 1, 2}, {3, 0, 4}, {5, 6, 0}});
+    g2.loadGraph({{0, 2, 0}, {0, 0, 1}, {1, 0, 0}});
+    g3.loadGraph({{0, 1, 1}, {1, 0, 1}, {1, 1, 0}});
+
+    std::ostringstream os;
+    Graph fused = g1 + g2 - g3 * 2;
+    os << fused;
+    CHECK(os.str() == "[[0, 1, 0], [1, 0, 3], [4, 4, 0]]");
+    CHECK(fused == (g1 + g2) - (g3 + g3));
+
+    // A graph may be assigned an expression it appears in
+    Graph g = g1;
+    g = g2 - g * 3;
+    CHECK(g.getWeight(0, 1) == -1);
+    CHECK(g.getWeight(2, 1) == -18);
+    g += -g1 + g2;
+    CHECK(g.getWeight(2, 1) == -24);
+    g -= g * 2;
+    CHECK(g.getWeight(2, 1) == 24);
+
+    // Sums, differences and multiples of plain graphs go through the kernels, in place or not
+    const unsigned int n = 21;
+    std::vector<std::vector<int>> ma(n, std::vector<int>(n, 0)), mb(n, std::vector<int>(n, 0));
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            if (i != j)
+            {
+                ma[i][j] = static_cast<int>(i * 7 + j) - 40;
+                mb[i][j] = static_cast<int>(j * 5) - static_cast<int>(i);
+            }
+        }
+    }
+    Graph a, b;
+    a.loadGraph(ma);
+    b.loadGraph(mb);
+    Graph diff = a - b, swapped = b;
+    swapped = a - swapped;
+    Graph negated = a;
+    negated = -negated;
+    Graph tripled = a * 3, accumulated = a;
+    accumulated += b * 4;
+    accumulated -= a * 2;
+    bool same = true;
+    for (unsigned int i = 0; i < n; ++i)
+    {
+        for (unsigned int j = 0; j < n; ++j)
+        {
+            same = same && diff.getWeight(i, j) == ma[i][j] - mb[i][j] && swapped.getWeight(i, j) == ma[i][j] - mb[i][j] &&
+                   negated.getWeight(i, j) == -ma[i][j] && tripled.getWeight(i, j) == 3 * ma[i][j] &&
+                   accumulated.getWeight(i, j) == 4 * mb[i][j] - ma[i][j];
+        }
+    }
+    CHECK(same);
+
+    // Expressions mix with graph products, comparisons and queries as graphs did
+    Graph product = g1 * g2;
+    CHECK((g1 + g2) * g3 == Graph(g1 + g2) * g3);
+    CHECK((g1 * 2) * g2 == product * 2);
+    CHECK(g2 * (g1 * 2) == g2 * g1 * 2);
+    CHECK((g1 + g1) * (g2 - g3) == (g1 * 2) * Graph(g2 - g3));
+    CHECK((g1 + g2) == g2 + g1);
+    CHECK(g1 * 2 == g1 + g1);
+    CHECK_FALSE((g1 + g2) != (g2 + g1));
+    CHECK(g1 * 2 != g1);
+    CHECK((g1 + g2 < g1 * 3) == (Graph(g1 + g2) < Graph(g1 * 3)));
+    CHECK((g1 - g1 <= g1) == (Graph(g1 - g1) <= g1));
+    CHECK((g1 > g1 - g1) == (g1 > Graph(g1 - g1)));
+    CHECK(g1 + g2 >= +(g1 + g2));
+    CHECK((g1 + g2).getNumVertices() == 3);
+    CHECK((g1 - g1).getNumEdges() == 0);
+    CHECK((g1 + g2).getWeight(0, 1) == 3);
+    CHECK((g2 * 4).containsEdge(1, 2));
+
+    // Size mismatches are reported where the expression is built
+    Graph small;
+    small.loadGraph({{0, 1}, {1, 0}});
+    CHECK_THROWS(g1 + g2 - small);
+    CHECK_THROWS(g1 += g2 - small);
+    CHECK_THROWS(g1 -= -small);
+
+    // Multiples of a sparse graph stay sparse; sums with sparse operands are dense
+    std::vector<Edge> edges;
+    for (unsigned int u = 0; u + 1 < 100; ++u)
+    {
+        edges.push_back(Edge{u, u + 1, 1});
+    }
+    Graph sparse;
+    sparse.loadEdges(100, edges);
+    Graph scaled = -(sparse * 3);
+    CHECK(scaled.getRepresentation() == Representation::Sparse);
+    CHECK(scaled.getWeight(4, 5) == -3);
+    Graph zero = sparse * 0;
+    CHECK(zero.getRepresentation() == Representation::Sparse);
+    CHECK(zero.getNumEdges() == 0);
+    Graph sum = sparse + scaled;
+    CHECK(sum.getRepresentation() == Representation::Dense);
+    CHECK(sum.getWeight(4, 5) == -2);
+    sparse = sparse - sparse * 2;
+    CHECK(sparse.getWeight(4, 5) == -1);
+}
+
+TEST_CASE("Test Move Semantics")
+{
+    CHECK(std::is_nothrow_move_constructible<Graph>::value);
+    CHECK(std::is_nothrow_move_assignable<Graph>::value);
+
+    std::vector<std::vector<int>> matrix = {{0, 1, 2}, {3, 0, 4}, {5, 6, 0}};
+    Graph a;
+    a.loadGraph(std::move(matrix));
+    CHECK(matrix.empty());
+    CHECK(a.getWeight(2, 1) == 6);
+
+    // A rejected matrix is left untouched
+    std::vector<std::vector<int>> invalid = {{1, 0}, {0, 0}};
+    Graph b;
+    CHECK_THROWS(b.loadGraph(std::move(invalid)));
+    CHECK(invalid.size() == 2);
+
+    // Moving hands over the rows and leaves an empty graph behind
+    const int *rows = a.getRow(0);
+    Graph moved(std::move(a));
+    CHECK(moved.getRow(0) == rows);
+    CHECK(a.getNumVertices() == 0);
+    a = std::move(moved);
+    CHECK(a.getRow(0) == rows);
+    CHECK(moved.getNumVertices() == 0);
+
+    // Temporary left operands are reused in place
+    Graph c = a;
+    rows = c.getRow(0);
+    Graph sum = std::move(c) + a - a * 2 + a;
+    CHECK(sum.getRow(0) == rows);
+    CHECK(sum.getWeight(0, 2) == 2);
+    Graph negated = -std::move(sum) * 3;
+    CHECK(negated.getRow(0) == rows);
+    CHECK(negated.getWeight(0, 2) == -6);
+    CHECK_THROWS(std::move(negated) + Graph());
+}
+
+TEST_CASE("Test Cached Graph Metadata")
+{
+    Graph g;
+    CHECK(g.getNumEdges() == 0);
+    CHECK(g.isSymmetric());
+    g.loadGraph({{0, 4, 0}, {4, 0, -2}, {0, -2, 0}});
+    CHECK(g.getNumEdges() == 2);
+    CHECK(g.getMinWeight() == -2);
+    CHECK(g.getMaxWeight() == 4);
+    CHECK(g.hasNegativeWeight());
+    CHECK(g.isSymmetric());
+
+    // Every mutator keeps the cached answers in line with the weights
+    g *= -3;
+    CHECK(g.getMinWeight() == -12);
+    CHECK(g.getMaxWeight() == 6);
+    CHECK(g.isSymmetric());
+    ++g;
+    CHECK(g.getNumEdges() == 4); // the diagonal is no longer zero
+    CHECK(g.getMinWeight() == -11);
+    --g;
+    CHECK(g.getNumEdges() == 2);
+    Graph directed;
+    directed.loadGraph({{0, 1, 0}, {0, 0, 0}, {0, 0, 0}});
+    g += directed;
+    CHECK_FALSE(g.isSymmetric());
+    g -= directed;
+    CHECK(g.isSymmetric());
+    CHECK_FALSE(directed.transpose().isSymmetric());
+    CHECK(directed.transpose().getMaxWeight() == 1);
+    g = g * 0;
+    CHECK(g.getNumEdges() == 0);
+    CHECK_FALSE(g.hasNegativeWeight());
+    g = directed - directed * 3;
+    CHECK(g.getMinWeight() == -2);
+    CHECK_FALSE(g.isSymmetric());
+
+    // Overflowing products are recounted instead of extrapolated
+    Graph big;
+    big.loadGraph({{0, 65536}, {1, 0}});
+    big *= 65536;
+    CHECK(big.getNumEdges() == 0);
+    CHECK(big.getMaxWeight() == 65536);
+    std::vector<Edge> wrapping = {Edge{0, 1, 65536}, Edge{1, 0, 1}, Edge{2, 3, -65536}, Edge{3, 2, 3}};
+    Graph bigSparse;
+    bigSparse.loadEdges(100, wrapping);
+    REQUIRE(bigSparse.getRepresentation() == Representation::Sparse);
+    bigSparse *= 65536;
+    CHECK(bigSparse.getRepresentation() == Representation::Sparse);
+    CHECK(bigSparse.getNumEdges() == 1);
+    CHECK(bigSparse.getMaxWeight() == 196608);
+    CHECK_FALSE(bigSparse.containsEdge(0, 1));
+    CHECK(bigSparse.neighbors(0).begin() == bigSparse.neighbors(0).end());
+    CHECK((*bigSparse.neighbors(3).begin()).vertex == 2);
+    Graph bigDense = bigSparse;
+    bigDense.setRepresentation(Representation::Dense);
+    CHECK(bigDense == bigSparse);
+
+    // Sparse graphs and layout changes keep the same metadata
+    std::vector<Edge> edges;
+    for (unsigned int u = 0; u + 1 < 100; ++u)
+    {
+        edges.push_back(Edge{u, u + 1, static_cast<int>(u) - 50});
+    }
+    Graph sparse;
+    sparse.loadEdges(100, edges);
+    CHECK(sparse.getMinWeight() == -50);
+    CHECK(sparse.getMaxWeight() == 48);
+    sparse.setRepresentation(Representation::Dense);
+    CHECK(sparse.getMinWeight() == -50);
+    CHECK_FALSE(sparse.isSymmetric());
+
+    // Comparisons use the cached edge counts
+    std::vector<Graph> graphs(3);
+    graphs[0].loadGraph({{0, 1, 1}, {1, 0, 1}, {1, 1, 0}});
+    graphs[1].loadGraph({{0, 0, 0}, {0, 0, 0}, {0, 0, 0}});
+    graphs[2].loadGraph({{0, 1, 0}, {1, 0, 0}, {0, 0, 0}});
+    std::sort(graphs.begin(), graphs.end());
+    CHECK(graphs[0].getNumEdges() == 0);
+    CHECK(graphs[1].getNumEdges() == 1);
+    CHECK(graphs[2].getNumEdges() == 3);
+}
+
+TEST_CASE("Test Bitset Representation")
+{
+    Graph g;
+    g.loadGraph({{0, 2, 0, 2}, {2, 0, 2, 0}, {0, 2, 0, 2}, {2, 0, 2, 0}});
+    g.setRepresentation(Representation::Bitset);
+    CHECK(g.getRepresentation() == Representation::Bitset);
+    CHECK(g.getBitWeight() == 2);
+    CHECK(g.getBitRow(0)[0] == 0xAu);
+    CHECK(g.containsEdge(0, 3));
+    CHECK_FALSE(g.containsEdge(0, 2));
+    CHECK(g.getWeight(1, 2) == 2);
+    CHECK(g.getNumEdges() == 4);
+    CHECK_THROWS_AS(g.getRow(0), std::logic_error);
+    std::ostringstream os;
+    os << g;
+    CHECK(os.str() == "[[0, 2, 0, 2], [2, 0, 2, 0], [0, 2, 0, 2], [2, 0, 2, 0]]");
+    CHECK(Algorithms::isBipartite(g) == "The graph is bipartite: A={0, 2}, B={1, 3}");
+    CHECK(Algorithms::shortestPath(g, 0, 2) == "0->1->2");
+
+    // Scaling keeps the layout, sums are dense
+    Graph scaled = g * -3;
+    CHECK(scaled.getRepresentation() == Representation::Bitset);
+    CHECK(scaled.getWeight(0, 1) == -6);
+    CHECK(Graph(g + g).getWeight(0, 1) == 4);
+    g *= 0;
+    CHECK(g.getNumEdges() == 0);
+
+    // Only graphs whose edges share one weight fit in a bitset
+    Graph weighted;
+    weighted.loadGraph({{0, 1}, {2, 0}});
+    CHECK_THROWS_AS(weighted.setRepresentation(Representation::Bitset), std::invalid_argument);
+    CHECK(weighted.getRepresentation() == Representation::Dense);
+
+    // The word-parallel algorithms agree with the dense ones, across several words per row
+    std::mt19937 rng(15);
+    for (unsigned int trial = 0; trial < 30; ++trial)
+    {
+        unsigned int n = 1 + rng() % 200;
+        unsigned int density = 1 + rng() % 40;
+        bool undirected = trial % 2 == 0;
+        std::vector<std::vector<int>> matrix(n, std::vector<int>(n, 0));
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 1000 < density)
+                {
+                    matrix[u][v] = 1;
+                    if (undirected)
+                    {
+                        matrix[v][u] = 1;
+                    }
+                }
+            }
+        }
+        Graph dense, bits;
+        dense.loadGraph(matrix);
+        dense.setRepresentation(Representation::Dense);
+        bits.loadGraph(matrix);
+        bits.setRepresentation(Representation::Bitset);
+
+        CHECK(bits == dense);
+        CHECK(bits.transpose() == dense.transpose());
+        CHECK(bits.isSymmetric() == dense.isSymmetric());
+        CHECK(Algorithms::isConnected(bits) == Algorithms::isConnected(dense));
+        CHECK(Algorithms::isBipartite(bits) == Algorithms::isBipartite(dense));
+        CHECK(Algorithms::isContainsCycle(bits) == Algorithms::isContainsCycle(dense));
+        int mismatches = 0;
+        for (unsigned int q = 0; q < 10; ++q)
+        {
+            unsigned int s = rng() % n;
+            unsigned int t = rng() % n;
+            PathResult a, b;
+            Algorithms::findPath(dense, s, t, a);
+            Algorithms::findPath(bits, s, t, b);
+            mismatches += a.found != b.found || a.vertices.size() != b.vertices.size();
+            for (std::size_t i = 0; i + 1 < b.vertices.size(); ++i)
+            {
+                mismatches += !bits.containsEdge(b.vertices[i], b.vertices[i + 1]);
+            }
+        }
+        CHECK(mismatches == 0);
+
+        Graph back = bits;
+        back.setRepresentation(Representation::Sparse);
+        CHECK(back == dense);
+    }
+}
+
+TEST_CASE("Test Semiring Products")
+{
+    Graph path;
+    path.loadGraph({{0, 4, 0, 0}, {0, 0, -1, 0}, {0, 0, 0, 2}, {0, 0, 0, 0}});
+
+    // Lightest walks of at most two edges; unreachable pairs stay 0
+    Graph distances = path.product<MinPlus>(path);
+    CHECK(distances.getWeight(0, 1) == 4);
+    CHECK(distances.getWeight(0, 2) == 3);
+    CHECK(distances.getWeight(1, 3) == 1);
+    CHECK(distances.getWeight(0, 3) == 0);
+    CHECK(distances.product<MinPlus>(distances).getWeight(0, 3) == 5);
+
+    // Pairs joined by at most two edges, as a bitset graph of weight 1
+    Graph reach = path.product<OrAnd>(path);
+    CHECK(reach.getRepresentation() == Representation::Bitset);
+    CHECK(reach.containsEdge(0, 2));
+    CHECK(!reach.containsEdge(0, 3));
+    CHECK(!reach.containsEdge(0, 0));
+    CHECK(reach.product<OrAnd>(reach).containsEdge(0, 3));
+
+    CHECK(path.product<PlusTimes>(path) == path * path);
+
+    // The min-plus row kernel skips infinite entries with every instruction set
+    const int infinite = std::numeric_limits<int>::max();
+    const InstructionSet sets[] = {InstructionSet::Scalar, InstructionSet::SSE41, InstructionSet::AVX2};
+    for (InstructionSet set : sets)
+    {
+        if (static_cast<int>(set) > static_cast<int>(Kernels::detect()))
+        {
+            continue;
+        }
+        Kernels::select(set);
+        std::vector<int> dst(37), src(37);
+        for (std::size_t i = 0; i < dst.size(); ++i)
+        {
+            dst[i] = i % 3 == 0 ? infinite : static_cast<int>(i);
+            src[i] = i % 5 == 0 ? infinite : static_cast<int>(i % 7) - 3;
+        }
+        std::vector<int> expected = dst;
+        Kernels::minPlus(dst.data(), src.data(), 2, dst.size());
+        int mismatches = 0;
+        for (std::size_t i = 0; i < dst.size(); ++i)
+        {
+            int candidate = src[i] == infinite ? infinite : src[i] + 2;
+            mismatches += dst[i] != std::min(expected[i], candidate);
+        }
+        CHECK(mismatches == 0);
+
+        // Sums near the limits saturate to [INT_MIN, INT_MAX - 1] and never turn into infinity
+        const int edges[] = {infinite - 1, infinite - 5, 10, -10, std::numeric_limits<int>::min(), std::numeric_limits<int>::min() + 3, infinite};
+        const int values[] = {100, -100, 5, infinite - 1, std::numeric_limits<int>::min(), 0};
+        for (int value : values)
+        {
+            std::vector<int> far(37, infinite), near(37);
+            for (std::size_t i = 0; i < near.size(); ++i)
+            {
+                near[i] = edges[i % 7];
+            }
+            Kernels::minPlus(far.data(), near.data(), value, far.size());
+            int wrong = 0;
+            for (std::size_t i = 0; i < far.size(); ++i)
+            {
+                long long sum = std::max<long long>(std::numeric_limits<int>::min(), std::min<long long>(infinite - 1, static_cast<long long>(near[i]) + value));
+                wrong += far[i] != (near[i] == infinite ? infinite : static_cast<int>(sum));
+            }
+            CHECK(wrong == 0);
+        }
+    }
+    Kernels::select(Kernels::detect());
+    Graph small;
+    small.loadGraph({{0, 1}, {1, 0}});
+    CHECK_THROWS_AS(path.product<MinPlus>(small), std::invalid_argument);
+    CHECK_THROWS_AS(path.product<OrAnd>(small), std::invalid_argument);
+
+    // Against the definitions, over every representation and across several blocks
+    std::mt19937 rng(16);
+    for (unsigned int trial = 0; trial < 12; ++trial)
+    {
+        unsigned int n = 1 + rng() % 300;
+        std::vector<std::vector<int>> a(n, std::vector<int>(n, 0)), b = a;
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 10 == 0)
+                {
+                    a[u][v] = static_cast<int>(rng() % 19) - 5;
+                }
+                if (u != v && rng() % 10 == 0)
+                {
+                    b[u][v] = static_cast<int>(rng() % 19) - 5;
+                }
+            }
+        }
+        Graph ga, gb;
+        ga.loadGraph(a);
+        gb.loadGraph(b);
+        ga.setRepresentation(trial % 2 == 0 ? Representation::Sparse : Representation::Dense);
+
+        Graph times = ga * gb;
+        Graph minPlus = ga.product<MinPlus>(gb);
+        Graph orAnd = ga.product<OrAnd>(gb);
+        int mismatches = 0;
+        for (unsigned int i = 0; i < n; ++i)
+        {
+            for (unsigned int j = 0; j < n; ++j)
+            {
+                long long sum = 0;
+                long long lightest = std::numeric_limits<long long>::max();
+                bool reachable = false;
+                for (unsigned int k = 0; k < n; ++k)
+                {
+                    sum += static_cast<long long>(a[i][k]) * b[k][j];
+                    bool left = i == k || a[i][k] != 0;
+                    bool right = k == j || b[k][j] != 0;
+                    if (left && right)
+                    {
+                        lightest = std::min(lightest, static_cast<long long>(a[i][k]) + b[k][j]);
+                        reachable = true;
+                    }
+                }
+                mismatches += times.getWeight(i, j) != sum;
+                mismatches += minPlus.getWeight(i, j) != (reachable ? lightest : 0);
+                mismatches += orAnd.containsEdge(i, j) != (reachable && i != j);
+            }
+        }
+        CHECK(mismatches == 0);
+    }
+}
+
+TEST_CASE("Test Matrix Power")
+{
+    Graph triangle;
+    triangle.loadGraph({{0, 1, 1}, {1, 0, 1}, {1, 1, 0}});
+
+    // Closed walks of a triangle: ((2)^k + 2(-1)^k) / 3 on the diagonal
+    std::ostringstream identity, cube;
+    identity << triangle.pow(0);
+    cube << triangle.pow(3);
+    CHECK(identity.str() == "[[1, 0, 0], [0, 1, 0], [0, 0, 1]]");
+    CHECK(cube.str() == "[[2, 3, 3], [3, 2, 3], [3, 3, 2]]");
+    CHECK(triangle.pow(1) == triangle);
+
+    // Every exponent agrees with repeated multiplication, on every representation
+    std::mt19937 rng(17);
+    for (unsigned int trial = 0; trial < 6; ++trial)
+    {
+        unsigned int n = 1 + rng() % 90;
+        std::vector<std::vector<int>> matrix(n, std::vector<int>(n, 0));
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 8 == 0)
+                {
+                    matrix[u][v] = static_cast<int>(rng() % 5) - 2;
+                }
+            }
+        }
+        Graph g;
+        g.loadGraph(matrix);
+        g.setRepresentation(trial % 2 == 0 ? Representation::Sparse : Representation::Dense);
+        Graph repeated = g;
+        for (unsigned int k = 1; k <= 9; ++k)
+        {
+            CHECK(g.pow(k) == repeated);
+            CHECK(g.pow(k, Overflow::Throw) == repeated);
+            repeated = repeated * g;
+        }
+    }
+
+    // Walk counts of the complete graph on 40 vertices grow like 39^k / 40: k = 6 fits in an int, k = 7 does not
+    std::vector<std::vector<int>> complete(40, std::vector<int>(40, 1));
+    for (unsigned int u = 0; u < 40; ++u)
+    {
+        complete[u][u] = 0;
+    }
+    Graph k40;
+    k40.loadGraph(complete);
+    CHECK(k40.pow(6, Overflow::Throw) == k40.pow(6));
+    CHECK_THROWS_AS(k40.pow(7, Overflow::Throw), std::overflow_error);
+
+    // Entries too large for plain 64-bit sums still give exact results or throw
+    Graph heavy;
+    heavy.loadGraph({{0, 2000000000, 0}, {-2000000000, 0, 0}, {0, 0, 0}});
+    CHECK_THROWS_AS(heavy.pow(2, Overflow::Throw), std::overflow_error);
+    Graph cancelling;
+    cancelling.loadGraph({{0, 2000000000, 2000000000, 0}, {0, 0, 0, 2000000000}, {0, 0, 0, -2000000000}, {0, 0, 0, 0}});
+    CHECK(cancelling.pow(2, Overflow::Throw).getNumEdges() == 0);
+
+    // A sum may leave the 64-bit range on the way and come back: three terms of about 2^62 in a
+    // row, then three that nearly cancel them, leave INT_MAX rather than an overflow
+    const int top = std::numeric_limits<int>::max();
+    std::vector<std::vector<int>> swing(8, std::vector<int>(8, 0));
+    for (unsigned int k = 1; k <= 6; ++k)
+    {
+        swing[0][k] = top;
+        swing[k][7] = k <= 3 ? top : -top;
+    }
+    swing[6][7] = -top + 1;
+    Graph swinging;
+    swinging.loadGraph(swing);
+    Graph squared = swinging.pow(2, Overflow::Throw);
+    CHECK(squared.getWeight(0, 7) == top);
+    CHECK(squared.getNumEdges() == 0);
+    CHECK(squared == swinging.pow(2));
+}
+
+TEST_CASE("Test Strassen Products")
+{
+    unsigned int cutoff = Graph::getStrassenCutoff();
+    std::mt19937 rng(18);
+    for (unsigned int trial = 0; trial < 10; ++trial)
+    {
+        // Powers of two, sizes that need padding, and several levels of recursion
+        unsigned int n = trial < 2 ? 64u << trial : 20 + rng() % 200;
+        std::vector<std::vector<int>> a(n, std::vector<int>(n, 0)), b = a;
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v)
+                {
+                    a[u][v] = static_cast<int>(rng() % 21) - 10;
+                    b[u][v] = rng() % 3 == 0 ? static_cast<int>(rng() % 7) - 3 : 0;
+                }
+            }
+        }
+        Graph ga, gb;
+        ga.loadGraph(a);
+        gb.loadGraph(b);
+
+        Graph::setStrassenCutoff(0);
+        Graph blocked = ga * gb;
+        Graph blockedPower = ga.pow(3);
+        Graph::setStrassenCutoff(8 + trial % 5);
+        CHECK(ga * gb == blocked);
+        CHECK(ga.pow(3) == blockedPower);
+        Graph::setStrassenCutoff(n - 1);
+        CHECK(ga * gb == blocked);
+    }
+
+    // Wrapping products stay identical, since the recursion adds and subtracts modulo 2^32,
+    // even where the quadrant sums themselves overflow
+    std::vector<std::vector<int>> large(40, std::vector<int>(40, 123456789)), extreme = large;
+    for (unsigned int u = 0; u < 40; ++u)
+    {
+        large[u][u] = 0;
+        for (unsigned int v = 0; v < 40; ++v)
+        {
+            extreme[u][v] = u == v ? 0 : (u + v) % 2 == 0 ? 2000000000 : -2000000000;
+        }
+    }
+    Graph g, h;
+    g.loadGraph(large);
+    h.loadGraph(extreme);
+    Graph::setStrassenCutoff(0);
+    Graph blocked = g * g;
+    Graph blockedExtreme = h * h;
+    Graph::setStrassenCutoff(5);
+    CHECK(g * g == blocked);
+    CHECK(h * h == blockedExtreme);
+    Graph::setStrassenCutoff(cutoff);
+}
+
+TEST_CASE("Test Sparse Products")
+{
+    // Both accumulators, at densities from a few entries per row to a fifth of the row
+    std::mt19937 rng(19);
+    const unsigned int densities[] = {2, 10, 60, 200};
+    for (unsigned int trial = 0; trial < 8; ++trial)
+    {
+        unsigned int n = 64 + rng() % 500;
+        std::vector<std::vector<int>> a(n, std::vector<int>(n, 0)), b = a;
+        for (unsigned int u = 0; u < n; ++u)
+        {
+            for (unsigned int v = 0; v < n; ++v)
+            {
+                if (u != v && rng() % 1000 < densities[trial % 4])
+                {
+                    a[u][v] = static_cast<int>(rng() % 9) - 4;
+                }
+                if (u != v && rng() % 1000 < densities[(trial + 1) % 4])
+                {
+                    b[u][v] = static_cast<int>(rng() % 9) - 4;
+                }
+            }
+        }
+        Graph ga, gb, da, db;
+        ga.loadGraph(a);
+        gb.loadGraph(b);
+        ga.setRepresentation(Representation::Sparse);
+        gb.setRepresentation(Representation::Sparse);
+        da.loadGraph(a);
+        db.loadGraph(b);
+        da.setRepresentation(Representation::Dense);
+        db.setRepresentation(Representation::Dense);
+
+        Graph sparse = ga * gb;
+        Graph dense = da * db;
+        CHECK(sparse.getRepresentation() == Representation::Sparse);
+        CHECK(dense.getRepresentation() == Representation::Dense);
+        CHECK(sparse == dense);
+        CHECK(sparse.getNumEdges() == dense.getNumEdges());
+        CHECK(ga.product<PlusTimes>(gb) == dense);
+    }
+
+    // Rows with few multiplications against many vertices go through the hash accumulator
+    const unsigned int n = 20000;
+    std::vector<Edge> edgesA, edgesB;
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (unsigned int e = 0; e < 3; ++e)
+        {
+            unsigned int v = rng() % n;
+            unsigned int w = rng() % 100;
+            if (v != u)
+            {
+                edgesA.push_back(Edge{u, v, static_cast<int>(rng() % 5) - 2});
+            }
+            if (w != u)
+            {
+                edgesB.push_back(Edge{u, w, static_cast<int>(rng() % 5) - 2});
+            }
+        }
+    }
+    Graph ga, gb;
+    ga.loadEdges(n, edgesA);
+    gb.loadEdges(n, edgesB);
+    Graph hashed = ga * gb;
+    CHECK(hashed.getRepresentation() == Representation::Sparse);
+    std::vector<std::map<unsigned int, int>> expected(n);
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        for (Neighbor k : ga.neighbors(u))
+        {
+            for (Neighbor v : gb.neighbors(k.vertex))
+            {
+                expected[u][v.vertex] += k.weight * v.weight;
+            }
+        }
+    }
+    int mismatches = 0;
+    for (unsigned int u = 0; u < n; ++u)
+    {
+        std::vector<std::pair<unsigned int, int>> want, got;
+        for (const std::pair<const unsigned int, int> &entry : expected[u])
+        {
+            if (entry.second != 0)
+            {
+                want.push_back(entry);
+            }
+        }
+        for (Neighbor v : hashed.neighbors(u))
+        {
+            got.push_back(std::make_pair(v.vertex, v.weight));
+        }
+        mismatches += want != got;
+    }
+    CHECK(mismatches == 0);
+
+    // Products and sums that overflow wrap around as in the dense product, in both accumulators;
+    // 65536 * 65536 wraps to zero and leaves no entry
+    const int large[] = {65536, -65536, 46341, 2147483647, -2147483647, 3};
+    for (unsigned int size : {64u, 6000u})
+    {
+        std::vector<Edge> wideA, wideB;
+        for (unsigned int u = 0; u < size; ++u)
+        {
+            for (unsigned int e = 0; e < 2; ++e)
+            {
+                unsigned int v = rng() % size, w = rng() % size;
+                if (v != u)
+                {
+                    wideA.push_back(Edge{u, v, large[rng() % 6]});
+                }
+                if (w != u)
+                {
+                    wideB.push_back(Edge{u, w, large[rng() % 6]});
+                }
+            }
+        }
+        Graph wa, wb;
+        wa.loadEdges(size, wideA);
+        wb.loadEdges(size, wideB);
+        wa.setRepresentation(Representation::Sparse);
+        wb.setRepresentation(Representation::Sparse);
+        Graph wrapped = wa * wb;
+        CHECK(wrapped.getRepresentation() == Representation::Sparse);
+        int wrong = 0;
+        for (unsigned int u = 0; u < size; ++u)
+        {
+            std::map<unsigned int, unsigned int> sums;
+            for (Neighbor k : wa.neighbors(u))
+            {
+                for (Neighbor v : wb.neighbors(k.vertex))
+                {
+                    sums[v.vertex] += static_cast<unsigned int>(k.weight) * static_cast<unsigned int>(v.weight);
+                }
+            }
+            std::vector<std::pair<unsigned int, int>> want, got;
+            for (const std::pair<const unsigned int, unsigned int> &entry : sums)
+            {
+                if (entry.second != 0)
+                {
+                    want.push_back(std::make_pair(entry.first, static_cast<int>(entry.second)));
+                }
+            }
+            for (Neighbor v : wrapped.neighbors(u))
+            {
+                got.push_back(std::make_pair(v.vertex, v.weight));
+            }
+            wrong += want != got;
+        }
+        CHECK(wrong == 0);
+        if (size == 64)
+        {
+            Graph da = wa, db = wb;
+            da.setRepresentation(Representation::Dense);
+            db.setRepresentation(Representation::Dense);
+            CHECK(wrapped == da * db);
+        }
+    }
+
+    // Sums that cancel leave no entry behind
+    Graph g;
+    g.loadGraph({{0, 1, 1, 0}, {0, 0, 0, 2}, {0, 0, 0, -2}, {0, 0, 0, 0}});
+    g.setRepresentation(Representation::Sparse);
+    Graph square = g * g;
+    CHECK(square.getRepresentation() == Representation::Sparse);
+    CHECK(square.getNumEdges() == 0);
+    CHECK(!square.containsEdge(0, 3));
+}
+
+TEST_CASE("Test Parallel Loading")
+{
+    // Errors are the ones of the first bad row, whichever block finds one first
+    std::vector<std::vector<int>> matrix(700, std::vector<int>(700, 0));
+    matrix[650][650] = 1;
+    matrix[600].pop_back();
+    Graph g;
+    try
+    {
+        g.loadGraph(matrix);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Not square");
+    }
+    matrix[600].push_back(0);
+    CHECK_THROWS_AS(g.loadGraph(matrix), std::invalid_argument);
+    matrix[650][650] = 0;
+
+    // Trusted input skips the checks but loads the same graph and metadata, dense or sparse
+    std::mt19937 rng(20);
+    for (unsigned int trial = 0; trial < 4; ++trial)
+    {
+        for (unsigned int u = 0; u < 700; ++u)
+        {
+            for (unsigned int v = 0; v < 700; ++v)
+            {
+                matrix[u][v] = u != v && rng() % 100 < (trial % 2 == 0 ? 3u : 40u) ? static_cast<int>(rng() % 21) - 10 : 0;
+            }
+        }
+        Graph checked, trusted, moved;
+        checked.loadGraph(matrix);
+        trusted.loadGraph(matrix, Validation::Trusted);
+        std::vector<std::vector<int>> copy = matrix;
+        moved.loadGraph(std::move(copy), Validation::Trusted);
+        CHECK(copy.empty());
+        CHECK(checked.getRepresentation() == (trial % 2 == 0 ? Representation::Sparse : Representation::Dense));
+        CHECK(trusted.getRepresentation() == checked.getRepresentation());
+        CHECK(trusted == checked);
+        CHECK(moved == checked);
+
+        int mismatches = 0;
+        std::size_t entries = 0;
+        int low = 0, high = 0;
+        for (unsigned int u = 0; u < 700; ++u)
+        {
+            for (unsigned int v = 0; v < 700; ++v)
+            {
+                mismatches += checked.getWeight(u, v) != matrix[u][v];
+                if (matrix[u][v] != 0)
+                {
+                    low = entries == 0 ? matrix[u][v] : std::min(low, matrix[u][v]);
+                    high = entries == 0 ? matrix[u][v] : std::max(high, matrix[u][v]);
+                    entries++;
+                }
+            }
+        }
+        CHECK(mismatches == 0);
+        CHECK(static_cast<std::size_t>(checked.getNumEdges()) == entries / 2);
+        CHECK(checked.getMinWeight() == low);
+        CHECK(checked.getMaxWeight() == high);
+    }
+
+    Graph empty;
+    empty.loadGraph({});
+    CHECK(empty.getNumVertices() == 0);
+    CHECK(empty.getNumEdges() == 0);
+}
+
+TEST_CASE("Test Binary Files")
+{
+    const std::string path = "test_graph.bin";
+    std::mt19937 rng(21);
+    std::vector<std::vector<int>> matrix(300, std::vector<int>(300, 0));
+    for (unsigned int u = 0; u < 300; ++u)
+    {
+        for (unsigned int v = 0; v < 300; ++v)
+        {
+            matrix[u][v] = u != v && rng() % 100 < 5 ? static_cast<int>(rng() % 21) - 10 : 0;
+        }
+    }
+    Graph weighted;
+    weighted.loadGraph(matrix);
+    for (std::vector<int> &row : matrix)
+    {
+        for (int &w : row)
+        {
+            w = w != 0 ? 3 : 0;
+        }
+    }
+    Graph uniform;
+    uniform.loadGraph(matrix);
+    uniform.setRepresentation(Representation::Bitset);
+
+    // Every layout comes back as it was saved, with its summaries
+    Graph dense = weighted, sparse = weighted;
+    dense.setRepresentation(Representation::Dense);
+    sparse.setRepresentation(Representation::Sparse);
+    for (const Graph *g : {&dense, &sparse, &uniform})
+    {
+        GraphIO::save(*g, path);
+        for (Validation validation : {Validation::Checked, Validation::Trusted})
+        {
+            Graph opened = GraphIO::open(path, validation);
+            CHECK(opened.getRepresentation() == g->getRepresentation());
+            CHECK(opened == *g);
+            CHECK(opened.getNumEdges() == g->getNumEdges());
+            CHECK(opened.getMinWeight() == g->getMinWeight());
+            CHECK(opened.getMaxWeight() == g->getMaxWeight());
+            CHECK(opened.getWeight(7, 7) == 0);
+        }
+    }
+    Graph empty;
+    GraphIO::save(empty, path);
+    CHECK(GraphIO::open(path).getNumVertices() == 0);
+
+    // Changing an opened graph leaves the file alone, and the mapping outlives the file name
+    GraphIO::save(weighted, path);
+    Graph opened = GraphIO::open(path);
+    opened *= 2;
+    opened += weighted;
+    CHECK(opened == weighted * 3);
+    CHECK(GraphIO::open(path) == weighted);
+    Graph copy = opened;
+    std::remove(path.c_str());
+    CHECK(opened == copy);
+    CHECK_THROWS_AS(GraphIO::open(path), std::runtime_error);
+
+    // A flipped payload byte is caught by the checksum, which Trusted skips
+    GraphIO::save(dense, path);
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        file.seekp(64 + 4 * (304 + 1)); // entry (1, 1); rows of 300 are padded to 304
+        file.put(1);
+    }
+    CHECK_THROWS_AS(GraphIO::open(path), std::invalid_argument);
+    CHECK(GraphIO::open(path, Validation::Trusted).getWeight(1, 1) == 1);
+
+    // Storage that no graph could have is rejected even under a valid checksum and a header that
+    // matches its entries. Each payload moves an entry somewhere invalid, then a trusted open and a
+    // save seal it again.
+    const std::string sealedPath = "test_graph_sealed.bin";
+    auto bytesOf = [&](const Graph &g)
+    {
+        GraphIO::save(g, path);
+        std::ifstream file(path, std::ios::binary);
+        return std::vector<char>((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    auto seal = [&](const std::vector<char> &bytes)
+    {
+        {
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+        GraphIO::save(GraphIO::open(path, Validation::Trusted), sealedPath);
+        CHECK_THROWS_AS(GraphIO::open(sealedPath), std::invalid_argument);
+        CHECK_NOTHROW(GraphIO::open(sealedPath, Validation::Trusted));
+    };
+    auto get = [](const std::vector<char> &bytes, std::size_t at, std::size_t size)
+    {
+        std::uint64_t value = 0;
+        std::memcpy(&value, bytes.data() + at, size);
+        return value;
+    };
+    auto put = [](std::vector<char> &bytes, std::size_t at, std::size_t size, std::uint64_t value)
+    {
+        std::memcpy(bytes.data() + at, &value, size);
+    };
+
+    // Dense: an entry of row 1 moved onto the diagonal, or into the padding after column 299
+    unsigned int column = 0;
+    while (column == 1 || dense.getWeight(1, column) == 0)
+    {
+        ++column;
+    }
+    for (std::size_t target : {1u, 300u})
+    {
+        std::vector<char> bytes = bytesOf(dense);
+        std::uint64_t weight = get(bytes, 64 + 4 * (304 + column), 4);
+        put(bytes, 64 + 4 * (304 + column), 4, 0);
+        put(bytes, 64 + 4 * (304 + target), 4, weight);
+        seal(bytes);
+    }
+
+    // Bitset: a bit of row 1 moved onto the diagonal, or past the last vertex (rows are 5 words)
+    column = 0;
+    while (column == 1 || !uniform.containsEdge(1, column))
+    {
+        ++column;
+    }
+    for (std::size_t target : {1u, 300u})
+    {
+        std::vector<char> bytes = bytesOf(uniform);
+        for (std::size_t bit : {static_cast<std::size_t>(column), target})
+        {
+            std::size_t at = 64 + 40 + 8 * (bit / 64);
+            put(bytes, at, 8, get(bytes, at, 8) ^ std::uint64_t(1) << (bit % 64));
+        }
+        seal(bytes);
+    }
+
+    // Sparse: the first column after the diagonal renamed to the diagonal, which keeps the row sorted
+    {
+        std::vector<char> bytes = bytesOf(sparse);
+        std::size_t columns = 64 + (301 * 8 + 63) / 64 * 64;
+        bool moved = false;
+        for (std::size_t u = 0; u < 300 && !moved; ++u)
+        {
+            std::size_t end = get(bytes, 64 + 8 * (u + 1), 8);
+            for (std::size_t i = get(bytes, 64 + 8 * u, 8); i < end && !moved; ++i)
+            {
+                if (get(bytes, columns + 4 * i, 4) > u)
+                {
+                    put(bytes, columns + 4 * i, 4, u);
+                    moved = true;
+                }
+            }
+        }
+        REQUIRE(moved);
+        seal(bytes);
+    }
+    std::remove(sealedPath.c_str());
+
+    // Foreign and truncated files are rejected either way
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file << std::string(128, 'x');
+    }
+    CHECK_THROWS_AS(GraphIO::open(path, Validation::Trusted), std::invalid_argument);
+    GraphIO::save(sparse, path);
+    REQUIRE(truncate(path.c_str(), 200) == 0);
+    CHECK_THROWS_AS(GraphIO::open(path, Validation::Trusted), std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Test Edge List Parsing")
+{
+    // Blanks, comments, CRLF, signs and a missing final newline
+    std::istringstream text("# u v w\n0 1 5\n\n1\t2   -3\r\n% note\n  2 0 +7  \n1 2 4\n3 0 0\n0 2 2147483647\n2 1 -2147483648");
+    Graph g = GraphIO::readEdges(text);
+    CHECK(g.getNumVertices() == 4);
+    CHECK(g.getWeight(0, 1) == 5);
+    CHECK(g.getWeight(1, 2) == 4);
+    CHECK(g.getWeight(2, 0) == 7);
+    CHECK(g.getWeight(3, 0) == 0);
+    CHECK(g.getWeight(0, 2) == std::numeric_limits<int>::max());
+    CHECK(g.getWeight(2, 1) == std::numeric_limits<int>::min());
+    std::istringstream few("0 1 1\n");
+    CHECK(GraphIO::readEdges(few, 10).getNumVertices() == 10);
+    std::istringstream none("");
+    CHECK(GraphIO::readEdges(none).getNumVertices() == 0);
+
+    // Errors name the line
+    const char *bad[] = {"0 1 1\n0 1\n", "0 1 1 1\n", "0 x 1\n", "0 1 2147483648\n", "0 4294967295 1\n", "0 1 -\n", "01 1\n"};
+    for (const char *input : bad)
+    {
+        std::istringstream in(input);
+        CHECK_THROWS_AS(GraphIO::readEdges(in), std::invalid_argument);
+    }
+    std::istringstream second("0 1 1\n0 1\n");
+    try
+    {
+        GraphIO::readEdges(second);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Malformed edge on line 2");
+    }
+    std::istringstream loop("0 1 1\n2 2 0\n2 2 1\n");
+    try
+    {
+        GraphIO::readEdges(loop);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Self-loop on line 3");
+    }
+    std::istringstream huge("0 1 1\n4000000000 0 1\n");
+    try
+    {
+        GraphIO::readEdges(huge);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Vertex number too large on line 2");
+    }
+    std::istringstream limit("0 " + std::to_string(GraphIO::MAX_TEXT_VERTICES) + " 1\n");
+    CHECK_THROWS_AS(GraphIO::readEdges(limit), std::invalid_argument);
+
+    // Several read chunks, a line longer than a chunk, and a file descriptor give what loadEdges gives
+    std::mt19937 rng(22);
+    std::vector<Edge> edges;
+    std::string lines = "#" + std::string(3 << 20, '-') + "\n";
+    for (unsigned int i = 0; i < 300000; ++i)
+    {
+        Edge edge{static_cast<unsigned int>(rng() % 5000), static_cast<unsigned int>(rng() % 5000), static_cast<int>(rng() % 2001) - 1000};
+        if (edge.from != edge.to)
+        {
+            edges.push_back(edge);
+            lines += std::to_string(edge.from) + " " + std::to_string(edge.to) + " " + std::to_string(edge.weight) + "\n";
+        }
+    }
+    Graph expected;
+    expected.loadEdges(5000, edges);
+    std::istringstream big(lines);
+    CHECK(GraphIO::readEdges(big, 5000) == expected);
+
+    const std::string path = "test_edges.txt";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << lines;
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    REQUIRE(fd >= 0);
+    CHECK(GraphIO::readEdges(fd, 5000) == expected);
+    close(fd);
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Test Parallel Edge List Files")
+{
+    // Chunks of the file are parsed apart and merged in file order, so later duplicates still win
+    std::mt19937 rng(23);
+    std::vector<Edge> edges;
+    std::string lines;
+    for (unsigned int i = 0; i < 200000; ++i)
+    {
+        Edge edge{static_cast<unsigned int>(rng() % 3000), static_cast<unsigned int>(rng() % 3000), static_cast<int>(rng() % 11) - 5};
+        if (edge.from != edge.to)
+        {
+            edges.push_back(edge);
+            lines += (i % 1000 == 0 ? "# comment\n" : "") + std::to_string(edge.from) + " " + std::to_string(edge.to) + " " + std::to_string(edge.weight) + "\n";
+        }
+    }
+    Graph expected;
+    expected.loadEdges(3000, edges);
+    const std::string path = "test_edges.txt";
+    std::vector<Edge> extended = edges;
+    extended.push_back(Edge{7, 8, 9});
+    Graph withTail;
+    withTail.loadEdges(3000, extended);
+
+    // The last line may lack its newline
+    const std::string endings[] = {"", "  ", "7 8 9"};
+    for (const std::string &ending : endings)
+    {
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << lines << ending;
+        }
+        CHECK(GraphIO::readEdges(path, 3000) == (ending.size() == 5 ? withTail : expected));
+    }
+
+    // A malformed line deep in the file is reported with its number in the whole file
+    std::size_t lineCount = static_cast<std::size_t>(std::count(lines.begin(), lines.end(), '\n'));
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << lines << "1 2\n" << lines;
+    }
+    try
+    {
+        GraphIO::readEdges(path);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Malformed edge on line " + std::to_string(lineCount + 1));
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << lines << lines << "5 5 -1\n";
+    }
+    try
+    {
+        GraphIO::readEdges(path);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Self-loop on line " + std::to_string(2 * lineCount + 1));
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+    }
+    CHECK(GraphIO::readEdges(path, 4).getNumVertices() == 4);
+    std::remove(path.c_str());
+    CHECK_THROWS_AS(GraphIO::readEdges(path), std::runtime_error);
+}
+
+TEST_CASE("Test Matrix Market and DIMACS")
+{
+    // The formatter agrees with std::to_string at the edges of the ranges
+    const long long values[] = {0, 9, 10, 99, 100, -1, -10, 1234567, std::numeric_limits<int>::max(), std::numeric_limits<int>::min(),
+                                std::numeric_limits<long long>::max(), std::numeric_limits<long long>::min()};
+    for (long long value : values)
+    {
+        char digits[24];
+        CHECK(std::string(digits, formatInt(digits, value)) == std::to_string(value));
+    }
+    char digits[24];
+    CHECK(std::string(digits, formatUnsigned(digits, std::numeric_limits<unsigned long long>::max())) == "18446744073709551615");
+
+    // Only non-zero entries are written, 1-based
+    Graph g;
+    g.loadGraph({{0, 5, 0}, {0, 0, -7}, {2147483647, 0, 0}});
+    std::ostringstream market;
+    GraphIO::writeMatrixMarket(g, market);
+    CHECK(market.str() == "%%MatrixMarket matrix coordinate integer general\n3 3 3\n1 2 5\n2 3 -7\n3 1 2147483647\n");
+    std::ostringstream dimacs;
+    GraphIO::writeDimacs(g, dimacs);
+    CHECK(dimacs.str() == "p sp 3 3\na 1 2 5\na 2 3 -7\na 3 1 2147483647\n");
+
+    // Round trips through streams and files, every representation
+    std::mt19937 rng(24);
+    std::vector<Edge> edges;
+    for (unsigned int i = 0; i < 20000; ++i)
+    {
+        Edge edge{static_cast<unsigned int>(rng() % 900), static_cast<unsigned int>(rng() % 900), static_cast<int>(rng() % 201) - 100};
+        if (edge.from != edge.to)
+        {
+            edges.push_back(edge);
+        }
+    }
+    Graph random;
+    random.loadEdges(1000, edges);
+    std::istringstream marketIn(market.str()), dimacsIn(dimacs.str());
+    CHECK(GraphIO::readMatrixMarket(marketIn) == g);
+    CHECK(GraphIO::readDimacs(dimacsIn) == g);
+    const std::string path = "test_graph.txt";
+    for (Representation representation : {Representation::Dense, Representation::Sparse})
+    {
+        random.setRepresentation(representation);
+        GraphIO::writeMatrixMarket(random, path);
+        Graph fromMarket = GraphIO::readMatrixMarket(path);
+        CHECK(fromMarket.getNumVertices() == 1000);
+        CHECK(fromMarket == random);
+        GraphIO::writeDimacs(random, path);
+        CHECK(GraphIO::readDimacs(path) == random);
+    }
+    Graph unweighted;
+    unweighted.loadGraph({{0, 1, 1}, {0, 0, 0}, {1, 0, 0}});
+    unweighted.setRepresentation(Representation::Bitset);
+    std::ostringstream bits;
+    GraphIO::writeDimacs(unweighted, bits);
+    CHECK(bits.str() == "p sp 3 3\na 1 2 1\na 1 3 1\na 3 1 1\n");
+
+    // Symmetric, skew-symmetric and pattern matrices, comments and blank lines
+    std::istringstream symmetric("%%MatrixMarket matrix coordinate integer symmetric\n% lower triangle\n\n3 3 2\n2 1 4\n3 2 -1");
+    Graph mirrored = GraphIO::readMatrixMarket(symmetric);
+    CHECK(mirrored.getWeight(0, 1) == 4);
+    CHECK(mirrored.getWeight(1, 0) == 4);
+    CHECK(mirrored.getWeight(1, 2) == -1);
+    CHECK(mirrored.isSymmetric());
+    std::istringstream skew("%%MatrixMarket Matrix Coordinate Integer Skew-Symmetric\r\n2 2 1\r\n2 1 3\r\n");
+    Graph skewed = GraphIO::readMatrixMarket(skew);
+    CHECK(skewed.getWeight(1, 0) == 3);
+    CHECK(skewed.getWeight(0, 1) == -3);
+    std::istringstream pattern("%%MatrixMarket matrix coordinate pattern general\n4 4 2\n1 4\n4 1\n");
+    Graph ones = GraphIO::readMatrixMarket(pattern);
+    CHECK(ones.getNumVertices() == 4);
+    CHECK(ones.getWeight(0, 3) == 1);
+    CHECK(ones.getWeight(3, 0) == 1);
+    std::istringstream commented("c a comment\n\np sp 2 1\nc another\na 2 1 -6\n");
+    CHECK(GraphIO::readDimacs(commented).getWeight(1, 0) == -6);
+
+    // Headers that are not supported and entries that break their header
+    const char *badMarket[] = {"%%MatrixMarket matrix array integer general\n2 2\n",
+                               "%%MatrixMarket matrix coordinate real general\n2 2 1\n1 2 0.5\n",
+                               "%%MatrixMarket matrix coordinate integer hermitian\n",
+                               "%MatrixMarket matrix coordinate integer general\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 3 0\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 2 1\n3 1 1\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 2 1\n0 1 1\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 2 2\n1 2 1\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 2 1\n1 2 1\n2 1 1\n",
+                               "%%MatrixMarket matrix coordinate integer general\n",
+                               "%%MatrixMarket matrix coordinate integer general\n2 2 1\n1 2\n"};
+    for (const char *input : badMarket)
+    {
+        std::istringstream in(input);
+        CHECK_THROWS_AS(GraphIO::readMatrixMarket(in), std::invalid_argument);
+    }
+    const char *badDimacs[] = {"a 1 2 3\n", "p sp 2 1\n", "p sp 2 1\na 1 3 1\n", "p sp 2 1\np sp 2 1\n", "p max 2 1\n", "p sp 2 1\nx\n"};
+    for (const char *input : badDimacs)
+    {
+        std::istringstream in(input);
+        CHECK_THROWS_AS(GraphIO::readDimacs(in), std::invalid_argument);
+    }
+    std::istringstream lineFour("%%MatrixMarket matrix coordinate integer general\n% comment\n3 3 2\n1 2 x\n");
+    try
+    {
+        GraphIO::readMatrixMarket(lineFour);
+        CHECK(false);
+    }
+    catch (const std::invalid_argument &error)
+    {
+        CHECK(std::string(error.what()) == "Malformed Matrix Market entry on line 4");
+    }
+
+    // Diagonal entries and self-loops name their line unless they are zero; duplicates keep the last value
+    auto marketError = [](const std::string &text)
+    {
+        std::istringstream in(text);
+        try
+        {
+            GraphIO::readMatrixMarket(in);
+        }
+        catch (const std::invalid_argument &error)
+        {
+            return std::string(error.what());
+        }
+        return std::string();
+    };
+    auto dimacsError = [](const std::string &text)
+    {
+        std::istringstream in(text);
+        try
+        {
+            GraphIO::readDimacs(in);
+        }
+        catch (const std::invalid_argument &error)
+        {
+            return std::string(error.what());
+        }
+        return std::string();
+    };
+    CHECK(marketError("%%MatrixMarket matrix coordinate integer symmetric\n3 3 2\n2 1 4\n2 2 5\n") == "Non-zero Matrix Market diagonal entry on line 4");
+    CHECK(marketError("%%MatrixMarket matrix coordinate pattern general\n3 3 1\n3 3\n") == "Non-zero Matrix Market diagonal entry on line 3");
+    CHECK(marketError("%%MatrixMarket matrix coordinate integer general\n3 3 1\n3 3 0\n").empty());
+    CHECK(dimacsError("c comment\np sp 3 2\na 1 2 1\na 3 3 -2\n") == "DIMACS self-loop on line 4");
+    CHECK(dimacsError("p sp 3 1\na 2 2 0\n").empty());
+    CHECK(marketError("%%MatrixMarket matrix coordinate integer general\n4000000000 4000000000 0\n") == "Matrix Market matrix too large on line 2");
+    CHECK(dimacsError("p sp 4000000000 0\n") == "DIMACS graph too large on line 1");
+    std::istringstream repeatedMarket("%%MatrixMarket matrix coordinate integer general\n2 2 3\n1 2 4\n1 2 -9\n2 1 1\n");
+    Graph lastMarket = GraphIO::readMatrixMarket(repeatedMarket);
+    CHECK(lastMarket.getWeight(0, 1) == -9);
+    CHECK(lastMarket.getNumEdges() == 1);
+    std::istringstream repeatedDimacs("p sp 2 3\na 2 1 3\na 1 2 5\na 2 1 8\n");
+    Graph lastDimacs = GraphIO::readDimacs(repeatedDimacs);
+    CHECK(lastDimacs.getWeight(1, 0) == 8);
+    CHECK(lastDimacs.getWeight(0, 1) == 5);
+    std::remove(path.c_str());
+    CHECK_THROWS_AS(GraphIO::readDimacs(path), std::runtime_error);
+}
+
+TEST_CASE("Test Output Modes")
+{
+    Graph g;
+    g.loadGraph({{0, 5, 0}, {0, 0, -7}, {2147483647, 0, 0}});
+    std::ostringstream plain;
+    plain << g;
+    CHECK(plain.str() == "[[0, 5, 0], [0, 0, -7], [2147483647, 0, 0]]");
+
+    // The mode sticks to its stream until dense switches it back
+    std::ostringstream triples;
+    triples << sparse << g << '\n' << g << '\n' << dense << g;
+    CHECK(triples.str() == "(0,1,5) (1,2,-7) (2,0,2147483647)\n(0,1,5) (1,2,-7) (2,0,2147483647)\n[[0, 5, 0], [0, 0, -7], [2147483647, 0, 0]]");
+    std::ostringstream other;
+    other << g;
+    CHECK(other.str() == plain.str());
+
+    Graph unweighted;
+    unweighted.loadGraph({{0, 1, 1}, {0, 0, 0}, {1, 0, 0}});
+    for (Representation representation : {Representation::Dense, Representation::Sparse, Representation::Bitset})
+    {
+        unweighted.setRepresentation(representation);
+        std::ostringstream both;
+        both << unweighted << ' ' << sparse << unweighted;
+        CHECK(both.str() == "[[0, 1, 1], [0, 0, 0], [1, 0, 0]] (0,1,1) (0,2,1) (2,0,1)");
+    }
+    Graph empty;
+    std::ostringstream nothing;
+    nothing << empty << sparse << empty;
+    CHECK(nothing.str() == "[]");
+
+    // Output longer than the buffer matches element-by-element insertion
+    std::mt19937 rng(25);
+    std::vector<std::vector<int>> matrix(300, std::vector<int>(300, 0));
+    std::ostringstream expected;
+    expected << "[";
+    for (unsigned int u = 0; u < 300; ++u)
+    {
+        expected << (u == 0 ? "[" : ", [");
+        for (unsigned int v = 0; v < 300; ++v)
+        {
+            matrix[u][v] = u != v ? static_cast<int>(rng()) : 0;
+            expected << (v == 0 ? "" : ", ") << matrix[u][v];
+        }
+        expected << "]";
+    }
+    expected << "]";
+    Graph large;
+    large.loadGraph(matrix);
+    std::ostringstream written;
+    written << large;
+    CHECK(written.str() == expected.str());
+}
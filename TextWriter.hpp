@@ -0,0 +1,122 @@
+#ifndef TEXT_WRITER_HPP
+#define TEXT_WRITER_HPP
+
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+
+namespace ariel {
+    // Write the decimal digits of value at out, which needs room for 20 characters, and return the
+    // end of the digits. Like std::to_chars, it produces two digits per division from a table.
+    inline char *formatUnsigned(char *out, unsigned long long value)
+    {
+        static const char PAIRS[] =
+            "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+            "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+            "8081828384858687888990919293949596979899";
+        char digits[20];
+        char *p = digits + sizeof(digits);
+        while (value >= 100)
+        {
+            std::size_t pair = static_cast<std::size_t>(value % 100) * 2;
+            value /= 100;
+            *--p = PAIRS[pair + 1];
+            *--p = PAIRS[pair];
+        }
+        if (value >= 10)
+        {
+            std::size_t pair = static_cast<std::size_t>(value) * 2;
+            *--p = PAIRS[pair + 1];
+            *--p = PAIRS[pair];
+        }
+        else
+        {
+            *--p = static_cast<char>('0' + value);
+        }
+        std::size_t count = static_cast<std::size_t>(digits + sizeof(digits) - p);
+        std::memcpy(out, p, count);
+        return out + count;
+    }
+
+    // Same, with a leading minus sign for negative values
+    inline char *formatInt(char *out, long long value)
+    {
+        if (value < 0)
+        {
+            *out++ = '-';
+            return formatUnsigned(out, 0ULL - static_cast<unsigned long long>(value));
+        }
+        return formatUnsigned(out, static_cast<unsigned long long>(value));
+    }
+
+    // Text collected in a fixed buffer and handed to an ostream in blocks of CAPACITY bytes, so that
+    // each number costs neither a virtual call nor a temporary string. Whatever is left is written
+    // by flush() or the destructor.
+    class TextWriter {
+        public:
+            static const std::size_t CAPACITY = 1 << 16;
+
+            explicit TextWriter(std::ostream &os) : os(os), used(0) {}
+            ~TextWriter() { flush(); }
+
+            TextWriter(const TextWriter &) = delete;
+            TextWriter &operator=(const TextWriter &) = delete;
+
+            void put(char c)
+            {
+                reserve(1);
+                buffer[used++] = c;
+            }
+
+            void write(const char *text, std::size_t count)
+            {
+                reserve(count);
+                if (count > CAPACITY)
+                {
+                    os.write(text, static_cast<std::streamsize>(count));
+                    return;
+                }
+                std::memcpy(buffer + used, text, count);
+                used += count;
+            }
+
+            void write(const char *text) { write(text, std::strlen(text)); }
+
+            void writeUnsigned(unsigned long long value)
+            {
+                reserve(20);
+                used = static_cast<std::size_t>(formatUnsigned(buffer + used, value) - buffer);
+            }
+
+            void writeInt(long long value)
+            {
+                reserve(20);
+                used = static_cast<std::size_t>(formatInt(buffer + used, value) - buffer);
+            }
+
+            void flush()
+            {
+                if (used != 0)
+                {
+                    os.write(buffer, static_cast<std::streamsize>(used));
+                    used = 0;
+                }
+            }
+
+        private:
+            void reserve(std::size_t count)
+            {
+                if (CAPACITY - used < count)
+                {
+                    flush();
+                }
+            }
+
+            std::ostream &os;
+            std::size_t used;
+            char buffer[CAPACITY];
+    };
+
+} // namespace ariel
+
+#endif // TEXT_WRITER_HPP
@@ -0,0 +1,129 @@
+#include "ThreadPool.hpp"
+
+namespace ariel
+{
+    // Set on pool workers and on callers while they run tasks, to serialize nested parallelFor calls
+    static thread_local bool insideTask = false;
+
+    ThreadPool &ThreadPool::instance()
+    {
+        static ThreadPool pool(std::thread::hardware_concurrency());
+        return pool;
+    }
+
+    ThreadPool::ThreadPool(unsigned int threads)
+        : task(nullptr), count(0), next(0), activeWorkers(0), generation(0), stopping(false)
+    {
+        for (unsigned int i = 1; i < threads; ++i)
+        {
+            workers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    unsigned int ThreadPool::size() const
+    {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &task)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        if (workers.empty() || count == 1 || insideTask)
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                task(i);
+            }
+            return;
+        }
+
+        std::lock_guard<std::mutex> runLock(runMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->task = &task;
+            this->count = count;
+            next.store(0);
+            error = nullptr;
+            activeWorkers = static_cast<unsigned int>(workers.size());
+            generation++;
+        }
+        wake.notify_all();
+
+        runTasks();
+
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [this]
+                      { return activeWorkers == 0; });
+        this->task = nullptr;
+        if (error)
+        {
+            std::exception_ptr thrown = error;
+            error = nullptr;
+            std::rethrow_exception(thrown);
+        }
+    }
+
+    // Claim indices until the current job runs out
+    void ThreadPool::runTasks()
+    {
+        insideTask = true;
+        for (std::size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+        {
+            try
+            {
+                (*task)(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+        insideTask = false;
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        unsigned long seen = 0;
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen]
+                          { return stopping || generation != seen; });
+                if (stopping)
+                {
+                    return;
+                }
+                seen = generation;
+            }
+
+            runTasks();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--activeWorkers == 0)
+            {
+                finished.notify_one();
+            }
+        }
+    }
+} // namespace ariel
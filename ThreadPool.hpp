@@ -0,0 +1,57 @@
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ariel {
+    // Fixed set of worker threads that run one parallelFor at a time.
+    // The calling thread takes part in the work, so a pool of size 1 has no workers at all.
+    class ThreadPool {
+        public:
+            // Shared pool with one thread per hardware thread
+            static ThreadPool &instance();
+
+            explicit ThreadPool(unsigned int threads);
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool &) = delete;
+            ThreadPool &operator=(const ThreadPool &) = delete;
+
+            // Number of threads that share a parallelFor, the caller included
+            unsigned int size() const;
+
+            // Run task(i) for every i in [0, count) and wait for all of them.
+            // Calls made from inside a task run serially on the calling thread.
+            // The first exception thrown by a task is rethrown here.
+            void parallelFor(std::size_t count, const std::function<void(std::size_t)> &task);
+
+        private:
+            void workerLoop();
+            void runTasks();
+
+            std::vector<std::thread> workers;
+            std::mutex mutex;
+            std::mutex runMutex; // one parallelFor at a time
+            std::condition_variable wake;
+            std::condition_variable finished;
+
+            // Current job, guarded by mutex except for the atomic counters
+            const std::function<void(std::size_t)> *task;
+            std::size_t count;
+            std::atomic<std::size_t> next;
+            unsigned int activeWorkers;
+            unsigned long generation;
+            bool stopping;
+            std::exception_ptr error;
+    };
+
+} // namespace ariel
+
+#endif // THREAD_POOL_HPP